@@ -25,6 +25,25 @@ bool ROSTypeDataPublisherExecutor::init(const std::string& config_file_path) {
         return false;
     }
 
+    // Optional real-time settings, applied to the threads lwrcl spawns and to the spinning thread
+    YAML::Node realtime = config["realtime"];
+    if (realtime) {
+        ThreadConfig thread_config;
+        if (!parse_scheduling_policy(realtime["policy"].as<std::string>("INHERIT"), thread_config.policy)) {
+            std::cerr << "Unknown scheduling policy!" << std::endl;
+            return false;
+        }
+        thread_config.priority = realtime["priority"].as<int>(0);
+        if (realtime["cpu_affinity"]) {
+            thread_config.cpu_affinity = realtime["cpu_affinity"].as<std::vector<int>>();
+        }
+        if (realtime["lock_memory"].as<bool>(false)) {
+            lock_memory();
+        }
+        set_default_thread_config(thread_config);
+        apply_thread_config(thread_config);
+    }
+
     lwrcl::dds::TopicQos topic_qos = lwrcl::dds::TOPIC_QOS_DEFAULT;
     publisher_ptr_ = create_publisher<CustomMessage>(&pub_message_type_, topic_name_, topic_qos);
     if (!publisher_ptr_) {
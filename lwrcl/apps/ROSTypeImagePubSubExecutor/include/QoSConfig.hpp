@@ -0,0 +1,24 @@
+#ifndef QOSCONFIG_H_
+#define QOSCONFIG_H_
+
+#include "lwrcl.hpp"
+#include <iostream>
+#include <string>
+#include <yaml-cpp/yaml.h>
+
+// Reads the optional "qos" profile name and "depth" of a topic entry.
+inline bool load_qos(const YAML::Node& topic_node, lwrcl::QoS& qos) {
+    if (topic_node["qos"]) {
+        std::string profile = topic_node["qos"].as<std::string>();
+        if (!lwrcl::parse_qos_profile(profile, qos)) {
+            std::cerr << "Error: Unknown QoS profile " << profile << std::endl;
+            return false;
+        }
+    }
+    if (topic_node["depth"]) {
+        qos.keep_last(topic_node["depth"].as<size_t>());
+    }
+    return true;
+}
+
+#endif /* QOSCONFIG_H_ */
@@ -21,8 +21,8 @@ FAST_DDS_DATA_TYPE(sensor_msgs, msg, Image)
 
 class ROSTypeImagePubSubEdge : public Node {
 public:
-    ROSTypeImagePubSubEdge(uint16_t domain_number);
-    ROSTypeImagePubSubEdge(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant);
+    ROSTypeImagePubSubEdge(uint16_t domain_number, const NodeOptions& options = NodeOptions());
+    ROSTypeImagePubSubEdge(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant, const NodeOptions& options = NodeOptions());
     virtual ~ROSTypeImagePubSubEdge();
 
     // Override init and run methods from Node
@@ -21,8 +21,8 @@ FAST_DDS_DATA_TYPE(sensor_msgs, msg, Image)
 using namespace lwrcl;
 class ROSTypeImagePubSubMono : public Node {
 public:
-    ROSTypeImagePubSubMono(uint16_t domain_number);
-    ROSTypeImagePubSubMono(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant);
+    ROSTypeImagePubSubMono(uint16_t domain_number, const NodeOptions& options = NodeOptions());
+    ROSTypeImagePubSubMono(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant, const NodeOptions& options = NodeOptions());
     virtual ~ROSTypeImagePubSubMono();
 
     // Override init and run methods from Node
@@ -42,7 +42,6 @@ private:
     sensor_msgs::msg::ImageType pub_message_type_;
     sensor_msgs::msg::ImageType sub_message_type_;
     int counter_;
-    std::shared_ptr<sensor_msgs::msg::Image> gray_msg_;
 };
 
 #endif /* ROSTYPEIMAGEPUBLSUBMONO_H_ */
@@ -33,8 +33,12 @@ int main(int argc, char **argv)
     // Initialize Executor
     MultiThreadedExecutor executor;
 
+    // Both nodes share one participant, so mono_out goes from Mono to Edge within the process.
+    NodeOptions node_options;
+    node_options.use_intra_process_comms = true;
+
     // Initialize and run the ROS-like node
-    ROSTypeImagePubSubMono rcl_like_node1(0);
+    ROSTypeImagePubSubMono rcl_like_node1(0, node_options);
     configPath1 = configPath + "config/config1.yaml"; // Append the relative path of the config file
     std::cout << "Using config file at: " << configPath1 << std::endl;
     
@@ -44,7 +48,7 @@ int main(int argc, char **argv)
         std::cerr << "Failed to initialize the ROSTypeImagePubSubMono." << std::endl;
         return 1;
     }
-    ROSTypeImagePubSubEdge rcl_like_node2(rcl_like_node1.get_participant());
+    ROSTypeImagePubSubEdge rcl_like_node2(rcl_like_node1.get_participant(), node_options);
     configPath2 = configPath + "config/config2.yaml"; // Append the relative path of the config file
     std::cout << "Using config file at: " << configPath2 << std::endl;
     
@@ -1,15 +1,16 @@
 #include "ROSTypeImagePubSubEdge.hpp"
+#include "QoSConfig.hpp"
 #include <iostream>
 #include <chrono>
 
-ROSTypeImagePubSubEdge::ROSTypeImagePubSubEdge(uint16_t domain_number)
-    : Node(domain_number), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
+ROSTypeImagePubSubEdge::ROSTypeImagePubSubEdge(uint16_t domain_number, const NodeOptions& options)
+    : Node(domain_number, options), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
     counter_ = 0;
 
     edge_msg_ = std::make_shared<sensor_msgs::msg::Image>();
 }
-ROSTypeImagePubSubEdge::ROSTypeImagePubSubEdge(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant)
-    : Node(participant), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
+ROSTypeImagePubSubEdge::ROSTypeImagePubSubEdge(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant, const NodeOptions& options)
+    : Node(participant, options), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
     counter_ = 0;
     
     edge_msg_ = std::make_shared<sensor_msgs::msg::Image>();
@@ -21,15 +22,23 @@ ROSTypeImagePubSubEdge::~ROSTypeImagePubSubEdge() {
 bool ROSTypeImagePubSubEdge::init(const std::string& config_file_path) {
     YAML::Node node = YAML::LoadFile(config_file_path);
     YAML::Node config = node["config"];
+    QoS publish_qos;
+    QoS subscribe_qos;
 
     for (const auto& topic_node : config["publish_topics"]) {
         publish_topic_name_ = topic_node["name"].as<std::string>("default_topic");
         interval_ms_ = topic_node["interval_ms"].as<uint16_t>(1000);
+        if (!load_qos(topic_node, publish_qos)) {
+            return false;
+        }
         std::cout << "Topic name: " << publish_topic_name_ << ", Interval: " << interval_ms_ << " ms" << std::endl;
     }
 
     for (const auto& topic_node : config["subscribe_topics"]) {
         subscribe_topic_name_ = topic_node["name"].as<std::string>("default_topic");
+        if (!load_qos(topic_node, subscribe_qos)) {
+            return false;
+        }
         std::cout << "Topic name: " << subscribe_topic_name_ << std::endl;
     }
 
@@ -38,14 +47,13 @@ bool ROSTypeImagePubSubEdge::init(const std::string& config_file_path) {
         return false;
     }
 
-    lwrcl::dds::TopicQos topic_qos = lwrcl::dds::TOPIC_QOS_DEFAULT;
-    publisher_ptr_ = create_publisher<sensor_msgs::msg::Image>(&pub_message_type_, publish_topic_name_, topic_qos);
+    publisher_ptr_ = create_publisher<sensor_msgs::msg::Image>(&pub_message_type_, publish_topic_name_, publish_qos);
     if (!publisher_ptr_) {
         std::cerr << "Error: Failed to create a publisher." << std::endl;
         return false;
     }
 
-    subscriber_ptr_ = create_subscription<sensor_msgs::msg::Image>(&sub_message_type_, subscribe_topic_name_, topic_qos, std::bind(&ROSTypeImagePubSubEdge::callbackSubscribe, this, std::placeholders::_1));
+    subscriber_ptr_ = create_subscription<sensor_msgs::msg::Image>(&sub_message_type_, subscribe_topic_name_, subscribe_qos, std::bind(&ROSTypeImagePubSubEdge::callbackSubscribe, this, std::placeholders::_1));
     if (subscriber_ptr_ == 0)
     {
         std::cerr << "Error: Failed to create a subscription." << std::endl;
@@ -1,18 +1,15 @@
 #include "ROSTypeImagePubSubMono.hpp"
+#include "QoSConfig.hpp"
 #include <iostream>
 #include <chrono>
 
-ROSTypeImagePubSubMono::ROSTypeImagePubSubMono(uint16_t domain_number)
-    : Node(domain_number), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
+ROSTypeImagePubSubMono::ROSTypeImagePubSubMono(uint16_t domain_number, const NodeOptions& options)
+    : Node(domain_number, options), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
     counter_ = 0;
-    
-    gray_msg_ = std::make_shared<sensor_msgs::msg::Image>();
 }
-ROSTypeImagePubSubMono::ROSTypeImagePubSubMono(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant)
-    : Node(participant), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
+ROSTypeImagePubSubMono::ROSTypeImagePubSubMono(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant, const NodeOptions& options)
+    : Node(participant, options), publish_topic_name_("default_topic"), subscribe_topic_name_("default_topic"), interval_ms_(1000) {
     counter_ = 0;
-    
-    gray_msg_ = std::make_shared<sensor_msgs::msg::Image>();
 }
 
 ROSTypeImagePubSubMono::~ROSTypeImagePubSubMono() {
@@ -22,15 +19,23 @@ bool ROSTypeImagePubSubMono::init(const std::string& config_file_path) {
     // Load configuration from YAML file
     YAML::Node node = YAML::LoadFile(config_file_path);
     YAML::Node config = node["config"];
+    QoS publish_qos;
+    QoS subscribe_qos;
 
     for (const auto& topic_node : config["publish_topics"]) {
         publish_topic_name_ = topic_node["name"].as<std::string>("default_topic");
         interval_ms_ = topic_node["interval_ms"].as<uint16_t>(1000);
+        if (!load_qos(topic_node, publish_qos)) {
+            return false;
+        }
         std::cout << "Topic name: " << publish_topic_name_ << ", Interval: " << interval_ms_ << " ms" << std::endl;
     }
 
     for (const auto& topic_node : config["subscribe_topics"]) {
         subscribe_topic_name_ = topic_node["name"].as<std::string>("default_topic");
+        if (!load_qos(topic_node, subscribe_qos)) {
+            return false;
+        }
         std::cout << "Topic name: " << subscribe_topic_name_ << std::endl;
     }
 
@@ -39,15 +44,14 @@ bool ROSTypeImagePubSubMono::init(const std::string& config_file_path) {
         return false;
     }
 
-    lwrcl::dds::TopicQos topic_qos = lwrcl::dds::TOPIC_QOS_DEFAULT;
-    publisher_ptr_ = create_publisher<sensor_msgs::msg::Image>(&pub_message_type_, publish_topic_name_, topic_qos);
+    publisher_ptr_ = create_publisher<sensor_msgs::msg::Image>(&pub_message_type_, publish_topic_name_, publish_qos);
     if (!publisher_ptr_) {
         std::cerr << "Error: Failed to create a publisher." << std::endl;
         return false;
     }
     
-    // Create a subscription with a topic named subscribe_topic_name_ and default QoS
-    subscriber_ptr_ = create_subscription<sensor_msgs::msg::Image>(&sub_message_type_, subscribe_topic_name_, topic_qos, std::bind(&ROSTypeImagePubSubMono::callbackSubscribe, this, std::placeholders::_1));
+    // Create a subscription with a topic named subscribe_topic_name_ and the configured QoS
+    subscriber_ptr_ = create_subscription<sensor_msgs::msg::Image>(&sub_message_type_, subscribe_topic_name_, subscribe_qos, std::bind(&ROSTypeImagePubSubMono::callbackSubscribe, this, std::placeholders::_1));
     if (subscriber_ptr_ == 0)
     {
         std::cerr << "Error: Failed to create a subscription." << std::endl;
@@ -73,11 +77,15 @@ void ROSTypeImagePubSubMono::callbackSubscribe(sensor_msgs::msg::Image *message)
     cv::Mat gray_image;
     cv::cvtColor(cv_image, gray_image, cv::COLOR_BGR2GRAY);
 
-    gray_msg_->width(width);
-    gray_msg_->height(height);
-    gray_msg_->encoding("mono8");
-    gray_msg_->step(gray_image.step);
-    gray_msg_->data(std::vector<uint8_t>(gray_image.data, gray_image.data + gray_image.total() * gray_image.elemSize()));
+    // A fresh message per frame, so the Edge node on the same participant receives it without
+    // a copy when intra-process communication is enabled. Image has an unbounded data sequence,
+    // so it is allocated on the heap rather than loaned from the DataWriter.
+    auto gray_msg = publisher_ptr_->borrow_loaned_message();
+    gray_msg->width(width);
+    gray_msg->height(height);
+    gray_msg->encoding("mono8");
+    gray_msg->step(gray_image.step);
+    gray_msg->data(std::vector<uint8_t>(gray_image.data, gray_image.data + gray_image.total() * gray_image.elemSize()));
     
-    publisher_ptr_->publish(gray_msg_.get());
+    publisher_ptr_->publish(std::move(gray_msg));
 }
\ No newline at end of file
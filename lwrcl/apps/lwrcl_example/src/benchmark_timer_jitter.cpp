@@ -0,0 +1,118 @@
+#include "lwrcl.hpp"
+
+#include <cstdlib>
+#include <iomanip>
+
+using namespace lwrcl;
+
+// Measures wakeup lateness (actual wakeup - deadline) of the Rate sleep path and of the
+// shared timer service for each backend and prints a histogram per configuration.
+//
+// usage: benchmark_timer_jitter [period_us=1000] [iterations=5000] [spin_us=50] [fifo_priority=0]
+
+struct BackendCase
+{
+    const char *name;
+    TimerBackendOptions options;
+};
+
+void print_statistics(const std::string &label, const LatencyStatistics &statistics)
+{
+    std::cout << std::fixed << std::setprecision(2)
+              << label
+              << " samples=" << statistics.count
+              << " mean=" << statistics.mean_ns() / 1000.0 << "us"
+              << " p50=" << statistics.percentile_ns(50) / 1000.0 << "us"
+              << " p99=" << statistics.percentile_ns(99) / 1000.0 << "us"
+              << " p99.9=" << statistics.percentile_ns(99.9) / 1000.0 << "us"
+              << " max=" << statistics.max_ns / 1000.0 << "us" << std::endl;
+    for (size_t i = 0; i < kLatencyHistogramBuckets; ++i)
+    {
+        if (statistics.buckets[i] == 0)
+        {
+            continue;
+        }
+        int64_t upper = i == 0 ? 0 : (int64_t(1) << i) - 1;
+        std::cout << "    <= " << std::setw(10) << upper / 1000.0 << "us : " << statistics.buckets[i] << std::endl;
+    }
+}
+
+LatencyStatistics measure_rate_path(std::chrono::nanoseconds period, int iterations, const TimerBackendOptions &options)
+{
+    LatencyHistogram histogram;
+    auto deadline = std::chrono::steady_clock::now() + period;
+    for (int i = 0; i < iterations; ++i)
+    {
+        precise_sleep_until(deadline, options);
+        histogram.record((std::chrono::steady_clock::now() - deadline).count());
+        deadline += period;
+    }
+    return histogram.snapshot();
+}
+
+LatencyStatistics measure_timer_service(std::chrono::nanoseconds period, int iterations, const TimerBackendOptions &options)
+{
+    LatencyHistogram histogram;
+    std::atomic<int> fired{0};
+    TimerService &service = TimerService::instance();
+    service.set_backend(options);
+    TimerService::TimerId id = service.add(period, [&](std::chrono::steady_clock::time_point due)
+                                           {
+                                               if (fired.load() < iterations)
+                                               {
+                                                   histogram.record((std::chrono::steady_clock::now() - due).count());
+                                                   ++fired;
+                                               } });
+    while (fired.load() < iterations)
+    {
+        std::this_thread::sleep_for(period * 10);
+    }
+    service.remove(id);
+    return histogram.snapshot();
+}
+
+int main(int argc, char **argv)
+{
+    auto period = std::chrono::microseconds(argc > 1 ? std::atoi(argv[1]) : 1000);
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 5000;
+    auto spin = std::chrono::microseconds(argc > 3 ? std::atoi(argv[3]) : 50);
+    int fifo_priority = argc > 4 ? std::atoi(argv[4]) : 0;
+
+    if (period.count() <= 0 || iterations <= 0)
+    {
+        std::cerr << "Error: period_us and iterations must be positive." << std::endl;
+        return 1;
+    }
+
+    if (fifo_priority > 0)
+    {
+        ThreadConfig thread_config;
+        thread_config.policy = SchedulingPolicy::FIFO;
+        thread_config.priority = fifo_priority;
+        set_default_thread_config(thread_config);
+        apply_thread_config(thread_config);
+        lock_memory();
+    }
+
+    std::vector<BackendCase> cases(4);
+    cases[0].name = "sleep_until";
+    cases[1].name = "sleep_until+spin";
+    cases[1].options.spin_threshold = spin;
+    cases[2].name = "timerfd";
+    cases[2].options.backend = TimerBackend::TIMERFD;
+    cases[3].name = "timerfd+spin";
+    cases[3].options.backend = TimerBackend::TIMERFD;
+    cases[3].options.spin_threshold = spin;
+
+    std::cout << "period=" << period.count() << "us iterations=" << iterations
+              << " spin=" << spin.count() << "us" << std::endl;
+    for (const auto &backend_case : cases)
+    {
+        print_statistics(std::string("[rate  ] ") + backend_case.name,
+                         measure_rate_path(period, iterations, backend_case.options));
+        print_statistics(std::string("[timer ] ") + backend_case.name,
+                         measure_timer_service(period, iterations, backend_case.options));
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#ifndef LWRCL_CALLBACK_GROUP_HPP_
+#define LWRCL_CALLBACK_GROUP_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "channel.hpp"
+
+namespace lwrcl
+{
+
+  enum class CallbackGroupType
+  {
+    MutuallyExclusive, // Callbacks of the group never run concurrently.
+    Reentrant          // Callbacks of the group may run concurrently on a multi-threaded executor.
+  };
+
+  // Set of subscriptions and timers that share a channel and a concurrency rule.
+  // Every node has a default MutuallyExclusive group; more are made with Node::create_callback_group.
+  class CallbackGroup
+  {
+  public:
+    CallbackGroup(CallbackGroupType type, const ChannelOptions &channel_options)
+        : type_(type), channel_(channel_options) {}
+
+    CallbackGroup(const CallbackGroup &) = delete;
+    CallbackGroup &operator=(const CallbackGroup &) = delete;
+
+    CallbackGroupType type() const
+    {
+      return type_;
+    }
+
+    Channel<ChannelCallback *> &get_channel()
+    {
+      return channel_;
+    }
+
+    // A MutuallyExclusive group is claimed by one thread while its callbacks run.
+    // Reentrant groups can always be claimed.
+    bool try_claim()
+    {
+      if (type_ == CallbackGroupType::Reentrant)
+      {
+        return true;
+      }
+      bool expected = false;
+      return claimed_.compare_exchange_strong(expected, true, std::memory_order_acquire);
+    }
+
+    void release()
+    {
+      if (type_ == CallbackGroupType::MutuallyExclusive)
+      {
+        claimed_.store(false, std::memory_order_release);
+      }
+    }
+
+    bool is_claimed() const
+    {
+      return claimed_.load(std::memory_order_relaxed);
+    }
+
+    // Subscriptions and timers of the group in creation order.
+    void add_callback(ChannelCallback *callback)
+    {
+      std::lock_guard<std::mutex> lock(callbacks_mutex_);
+      registered_callbacks_.push_back(callback);
+    }
+
+    std::vector<ChannelCallback *> get_callbacks()
+    {
+      std::lock_guard<std::mutex> lock(callbacks_mutex_);
+      return registered_callbacks_;
+    }
+
+    // Runs the callbacks pending on entry as one batch (a single one with priority dispatch);
+    // entries produced meanwhile are left for the next call so producers that outpace the
+    // callbacks cannot keep the caller here forever. The caller must hold the claim, and only
+    // one thread may call it at a time even for a Reentrant group.
+    void spin_some()
+    {
+      channel_.drain_into(callbacks_, channel_.get_batch_limit());
+      for (auto callback : callbacks_)
+      {
+        if (callback)
+        {
+          callback->invoke();
+        }
+      }
+      callbacks_.clear();
+    }
+
+  private:
+    const CallbackGroupType type_;
+    Channel<ChannelCallback *> channel_;
+    std::atomic<bool> claimed_{false};
+    std::vector<ChannelCallback *> callbacks_; // Reused batch buffer, keeps spin_some allocation-free.
+    std::vector<ChannelCallback *> registered_callbacks_;
+    std::mutex callbacks_mutex_;
+  };
+
+} // namespace lwrcl
+
+#endif // LWRCL_CALLBACK_GROUP_HPP_
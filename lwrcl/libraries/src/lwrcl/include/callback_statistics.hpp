@@ -0,0 +1,281 @@
+#ifndef LWRCL_CALLBACK_STATISTICS_HPP_
+#define LWRCL_CALLBACK_STATISTICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace lwrcl
+{
+
+  static const size_t kLatencyHistogramBuckets = 40;
+
+  // Snapshot of a LatencyHistogram. Bucket 0 counts 0 ns samples, bucket i counts samples in
+  // [2^(i-1), 2^i) ns; the last bucket also takes everything above.
+  struct LatencyStatistics
+  {
+    uint64_t count = 0;
+    int64_t total_ns = 0;
+    int64_t max_ns = 0;
+    std::array<uint64_t, kLatencyHistogramBuckets> buckets{};
+
+    double mean_ns() const
+    {
+      return count > 0 ? static_cast<double>(total_ns) / count : 0.0;
+    }
+
+    // Upper bound of the bucket holding the given percentile (0-100), capped at max_ns.
+    int64_t percentile_ns(double percentile) const
+    {
+      if (count == 0)
+      {
+        return 0;
+      }
+      uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count);
+      uint64_t seen = 0;
+      for (size_t i = 0; i < kLatencyHistogramBuckets; ++i)
+      {
+        seen += buckets[i];
+        if (seen > rank || seen == count)
+        {
+          int64_t upper = i == 0 ? 0 : (int64_t(1) << i) - 1;
+          return upper < max_ns ? upper : max_ns;
+        }
+      }
+      return max_ns;
+    }
+  };
+
+  // Log2-bucketed histogram of nanosecond samples. Recording is a handful of relaxed atomic
+  // adds, so it can stay enabled in production.
+  class LatencyHistogram
+  {
+  public:
+    void record(int64_t ns)
+    {
+      if (ns < 0)
+      {
+        ns = 0;
+      }
+      size_t bucket = 0;
+      if (ns > 0)
+      {
+        bucket = 64 - __builtin_clzll(static_cast<uint64_t>(ns));
+        if (bucket >= kLatencyHistogramBuckets)
+        {
+          bucket = kLatencyHistogramBuckets - 1;
+        }
+      }
+      buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+      count_.fetch_add(1, std::memory_order_relaxed);
+      total_ns_.fetch_add(ns, std::memory_order_relaxed);
+      int64_t max = max_ns_.load(std::memory_order_relaxed);
+      while (ns > max && !max_ns_.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+      {
+      }
+    }
+
+    LatencyStatistics snapshot() const
+    {
+      LatencyStatistics statistics;
+      statistics.count = count_.load(std::memory_order_relaxed);
+      statistics.total_ns = total_ns_.load(std::memory_order_relaxed);
+      statistics.max_ns = max_ns_.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < kLatencyHistogramBuckets; ++i)
+      {
+        statistics.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+      }
+      return statistics;
+    }
+
+  private:
+    std::array<std::atomic<uint64_t>, kLatencyHistogramBuckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> total_ns_{0};
+    std::atomic<int64_t> max_ns_{0};
+  };
+
+  struct CallbackStatisticsSnapshot
+  {
+    std::string name;              // Topic of a subscription, or "timer" with its period.
+    uint64_t invocations = 0;
+    uint64_t drops = 0;            // Evicted or rejected by a bounded channel.
+    LatencyStatistics queue_wait;  // Channel::produce to the start of ChannelCallback::invoke.
+    LatencyStatistics execution;   // Duration of the user callback.
+  };
+
+  // Counters of one subscription or timer. Channel::produce stamps each entry and invoke()
+  // pairs the oldest stamp with the invocation; channel entries of one callback are consumed
+  // in order, so the pairing is exact as long as fewer than kMaxPendingStamps are queued.
+  class CallbackStatistics
+  {
+  public:
+    static const size_t kMaxPendingStamps = 64;
+
+    // Enable before the callback is first produced so stamps and invocations stay paired.
+    void set_enabled(bool enabled)
+    {
+      enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool is_enabled() const
+    {
+      return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void set_name(const std::string &name)
+    {
+      name_ = name;
+    }
+
+    void record_enqueue()
+    {
+      if (!is_enabled())
+      {
+        return;
+      }
+      int64_t now = now_ns();
+      lock();
+      if (pending_ < kMaxPendingStamps && unstamped_ == 0)
+      {
+        stamps_[(head_ + pending_) % kMaxPendingStamps] = now;
+        ++pending_;
+      }
+      else
+      {
+        ++unstamped_; // Newest entries beyond the stamp window.
+      }
+      unlock();
+    }
+
+    // The entry just stamped was not queued; dropped is false when the channel was closed.
+    void record_reject(bool dropped)
+    {
+      if (!is_enabled())
+      {
+        return;
+      }
+      lock();
+      if (unstamped_ > 0)
+      {
+        --unstamped_;
+      }
+      else if (pending_ > 0)
+      {
+        --pending_;
+      }
+      unlock();
+      if (dropped)
+      {
+        drops_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    // The oldest queued entry was evicted without being invoked.
+    void record_drop()
+    {
+      if (!is_enabled())
+      {
+        return;
+      }
+      int64_t stamp;
+      pop_oldest(stamp);
+      drops_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Returns the start time to pass to end_invoke, or 0 when disabled.
+    int64_t begin_invoke()
+    {
+      if (!is_enabled())
+      {
+        return 0;
+      }
+      int64_t now = now_ns();
+      int64_t stamp;
+      if (pop_oldest(stamp))
+      {
+        queue_wait_.record(now - stamp);
+      }
+      return now;
+    }
+
+    void end_invoke(int64_t start)
+    {
+      if (start == 0)
+      {
+        return;
+      }
+      execution_.record(now_ns() - start);
+      invocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    CallbackStatisticsSnapshot snapshot() const
+    {
+      CallbackStatisticsSnapshot snapshot;
+      snapshot.name = name_;
+      snapshot.invocations = invocations_.load(std::memory_order_relaxed);
+      snapshot.drops = drops_.load(std::memory_order_relaxed);
+      snapshot.queue_wait = queue_wait_.snapshot();
+      snapshot.execution = execution_.snapshot();
+      return snapshot;
+    }
+
+  private:
+    static int64_t now_ns()
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+    }
+
+    // Returns false for an entry queued without a stamp.
+    bool pop_oldest(int64_t &stamp)
+    {
+      bool found = false;
+      lock();
+      if (pending_ > 0)
+      {
+        stamp = stamps_[head_];
+        head_ = (head_ + 1) % kMaxPendingStamps;
+        --pending_;
+        found = true;
+      }
+      else if (unstamped_ > 0)
+      {
+        --unstamped_;
+      }
+      unlock();
+      return found;
+    }
+
+    void lock()
+    {
+      while (stamps_lock_.test_and_set(std::memory_order_acquire))
+      {
+      }
+    }
+
+    void unlock()
+    {
+      stamps_lock_.clear(std::memory_order_release);
+    }
+
+    std::atomic<bool> enabled_{false};
+    std::string name_;
+    std::atomic_flag stamps_lock_ = ATOMIC_FLAG_INIT; // Held for a few instructions only.
+    std::array<int64_t, kMaxPendingStamps> stamps_{};
+    size_t head_{0};
+    size_t pending_{0};
+    size_t unstamped_{0};
+    std::atomic<uint64_t> invocations_{0};
+    std::atomic<uint64_t> drops_{0};
+    LatencyHistogram queue_wait_;
+    LatencyHistogram execution_;
+  };
+
+} // namespace lwrcl
+
+#endif // LWRCL_CALLBACK_STATISTICS_HPP_
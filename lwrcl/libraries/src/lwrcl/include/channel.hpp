@@ -1,9 +1,21 @@
 #ifndef LWRCL_CHANNEL_HPP_
 #define LWRCL_CHANNEL_HPP_
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "callback_statistics.hpp"
+#include "ring_buffer.hpp"
 
 namespace lwrcl
 {
@@ -12,69 +24,956 @@ namespace lwrcl
   {
   public:
     virtual ~ChannelCallback() = default;
-    virtual void invoke() = 0;
+
+    // Runs the callback and records its statistics.
+    void invoke()
+    {
+      int64_t start = statistics_.begin_invoke();
+      execute();
+      statistics_.end_invoke(start);
+    }
+
+    // Called instead of invoke() when a bounded channel evicts a queued entry.
+    virtual void discard() {}
+
+    CallbackStatistics &get_statistics()
+    {
+      return statistics_;
+    }
+
+    // Higher runs first on channels with ChannelOptions::priority_dispatch.
+    void set_priority(int priority)
+    {
+      priority_.store(priority, std::memory_order_relaxed);
+    }
+
+    int get_priority() const
+    {
+      return priority_.load(std::memory_order_relaxed);
+    }
+
+    // Pending-invocation count used instead of queue entries while a channel is in direct
+    // dispatch (see Channel::set_direct_dispatch).
+    void mark_ready()
+    {
+      ready_.fetch_add(1);
+    }
+
+    uint32_t take_ready()
+    {
+      return ready_.exchange(0);
+    }
+
+  protected:
+    virtual void execute() = 0;
+
+  private:
+    std::atomic<int> priority_{0};
+    std::atomic<uint32_t> ready_{0};
+    CallbackStatistics statistics_;
   };
 
+  // Releases whatever backs an entry a bounded Channel has evicted.
+  inline void discard_channel_entry(ChannelCallback *callback)
+  {
+    if (callback)
+    {
+      callback->get_statistics().record_drop();
+      callback->discard();
+    }
+  }
+
+  template <class T>
+  void discard_channel_entry(T &)
+  {
+  }
+
+  inline int channel_entry_priority(ChannelCallback *callback)
+  {
+    return callback ? callback->get_priority() : 0;
+  }
+
+  template <class T>
+  int channel_entry_priority(T &)
+  {
+    return 0;
+  }
+
+  // Statistics hooks of Channel::produce.
+  inline void channel_entry_produced(ChannelCallback *callback)
+  {
+    if (callback)
+    {
+      callback->get_statistics().record_enqueue();
+    }
+  }
+
+  template <class T>
+  void channel_entry_produced(T &)
+  {
+  }
+
+  inline void channel_entry_rejected(ChannelCallback *callback, bool dropped)
+  {
+    if (callback)
+    {
+      callback->get_statistics().record_reject(dropped);
+    }
+  }
+
+  template <class T>
+  void channel_entry_rejected(T &, bool)
+  {
+  }
+
+  // Direct dispatch only applies to ChannelCallback entries; other entry types stay queued.
+  inline bool channel_entry_mark_ready(ChannelCallback *callback)
+  {
+    if (!callback)
+    {
+      return false;
+    }
+    callback->mark_ready();
+    return true;
+  }
+
+  template <class T>
+  bool channel_entry_mark_ready(T &)
+  {
+    return false;
+  }
+
+  inline uint32_t channel_entry_take_ready(ChannelCallback *callback)
+  {
+    return callback ? callback->take_ready() : 0;
+  }
+
+  template <class T>
+  uint32_t channel_entry_take_ready(T &)
+  {
+    return 0;
+  }
+
+  enum class ChannelType
+  {
+    MUTEX_QUEUE,   // std::queue guarded by a mutex.
+    LOCK_FREE_RING // Bounded lock-free ring; the mutex is only taken to park or wake a waiting thread.
+  };
+
+  enum class OverflowPolicy
+  {
+    BLOCK,       // The producer waits until there is room.
+    DROP_OLDEST, // The oldest queued entry is evicted to make room.
+    DROP_NEWEST  // The incoming entry is rejected.
+  };
+
+  struct ChannelOptions
+  {
+    ChannelType type = ChannelType::MUTEX_QUEUE;
+    // Max queued entries. 0 means unbounded for MUTEX_QUEUE and kDefaultRingCapacity for
+    // LOCK_FREE_RING, whose capacity is always rounded up to a power of two.
+    size_t capacity = 0;
+    OverflowPolicy overflow_policy = OverflowPolicy::BLOCK;
+    // Hand out the highest-priority entry first instead of FIFO (MUTEX_QUEUE only).
+    // Entries of equal priority stay FIFO.
+    bool priority_dispatch = false;
+    // With priority_dispatch, an entry gains one priority level per aging period spent
+    // queued so low-priority work cannot starve. Zero disables aging.
+    std::chrono::nanoseconds priority_aging_period{0};
+  };
+
+  // Something besides the notifier a waiting thread can block on, such as a DDS WaitSet.
+  class ExternalWaiter
+  {
+  public:
+    virtual ~ExternalWaiter() = default;
+    // Returns after wake() or when the waiter's own conditions trigger. Only one thread at a time.
+    virtual void wait() = 0;
+    virtual void wake() = 0;
+  };
+
+  // Wakeup primitive that several channels signal so one consumer can block on all of them.
+  // The consumer reads the epoch, polls its channels, then waits for the epoch to move on;
+  // notify() only takes the mutex when a consumer is actually parked.
+  class EventNotifier
+  {
+  public:
+    uint64_t get_epoch() const
+    {
+      return epoch_.load(std::memory_order_seq_cst);
+    }
+
+    void notify()
+    {
+      epoch_.fetch_add(1, std::memory_order_seq_cst);
+      if (waiters_.load(std::memory_order_seq_cst) > 0)
+      {
+        {
+          std::lock_guard<std::mutex> lock{mtx_};
+          cv_.notify_all();
+        }
+        ExternalWaiter *external = external_.load(std::memory_order_acquire);
+        if (external)
+        {
+          external->wake();
+        }
+      }
+    }
+
+    // Returns once notify() has been called after epoch was read. With an external waiter one
+    // of the waiting threads blocks on it instead and may also return when its conditions
+    // trigger; callers poll again either way.
+    void wait(uint64_t epoch)
+    {
+      ExternalWaiter *external = external_.load(std::memory_order_acquire);
+      if (external && !external_busy_.exchange(true))
+      {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        if (epoch_.load(std::memory_order_seq_cst) == epoch)
+        {
+          external->wait();
+        }
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        external_busy_.store(false);
+        return;
+      }
+      std::unique_lock<std::mutex> lock{mtx_};
+      waiters_.fetch_add(1, std::memory_order_seq_cst);
+      cv_.wait(lock, [this, epoch]
+               { return epoch_.load(std::memory_order_seq_cst) != epoch; });
+      waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // Installs the external waiter on first use and returns the installed one. It lives as long
+    // as the notifier.
+    ExternalWaiter *set_external_waiter(std::unique_ptr<ExternalWaiter> waiter)
+    {
+      {
+        std::lock_guard<std::mutex> lock{mtx_};
+        if (!external_waiter_)
+        {
+          external_waiter_ = std::move(waiter);
+          external_.store(external_waiter_.get(), std::memory_order_release);
+        }
+      }
+      notify(); // Threads parked on the condition variable come back and may take the waiter.
+      return external_waiter_.get();
+    }
+
+    ExternalWaiter *get_external_waiter() const
+    {
+      return external_.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<int> waiters_{0};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::unique_ptr<ExternalWaiter> external_waiter_;
+    std::atomic<ExternalWaiter *> external_{nullptr};
+    std::atomic<bool> external_busy_{false}; // A thread is blocked in external_->wait().
+  };
+
+  static const size_t kDefaultRingCapacity = 1024;
+
   template <class T>
   class Channel
   {
   public:
-    void produce(T &&x)
+    explicit Channel(const ChannelOptions &options = ChannelOptions())
+        : type_(options.type), capacity_(options.capacity), overflow_policy_(options.overflow_policy),
+          priority_dispatch_(options.priority_dispatch), priority_aging_period_(options.priority_aging_period)
     {
-      std::lock_guard<std::mutex> lock{mtx_};
-      if (!closed_)
+      if (type_ == ChannelType::LOCK_FREE_RING)
       {
-        queue_.push(std::forward<T>(x));
-        cv_.notify_all();
+        if (priority_dispatch_)
+        {
+          throw std::invalid_argument("Priority dispatch requires ChannelType::MUTEX_QUEUE");
+        }
+        ring_ = std::make_unique<LockFreeRingBuffer<T>>(capacity_ > 0 ? capacity_ : kDefaultRingCapacity);
+        capacity_ = ring_->capacity();
       }
     }
 
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    // Returns false when the entry was not queued: the channel is closed, or it is full
+    // and the overflow policy is DROP_NEWEST.
+    bool produce(T &&x)
+    {
+      return produce_entry(x, true);
+    }
+
+    // Like produce, but a full channel with OverflowPolicy::BLOCK rejects the entry instead of
+    // waiting for space, counting it as dropped. For producers that must not block, such as a
+    // consumer thread or the shared timer thread.
+    bool try_produce(T &&x)
+    {
+      return produce_entry(x, false);
+    }
+
+    // Produces every entry of batch (moving from them) with a single lock acquisition and
+    // wakeup on the mutex queue. Returns how many were queued; when the channel is closed, or
+    // full with DROP_NEWEST, the rest of the batch from that point on is rejected.
+    size_t produce_batch(std::vector<T> &batch)
+    {
+      size_t produced = 0;
+      if (ring_ || direct_dispatch_.load())
+      {
+        while (produced < batch.size() && produce(std::move(batch[produced])))
+        {
+          ++produced;
+        }
+        bool dropped = !closed_.load();
+        for (size_t i = produced + 1; i < batch.size(); ++i)
+        {
+          if (dropped)
+          {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+          }
+          channel_entry_produced(batch[i]);
+          channel_entry_rejected(batch[i], dropped);
+        }
+        return produced;
+      }
+
+      for (auto &x : batch)
+      {
+        channel_entry_produced(x);
+      }
+      std::vector<T> evicted;
+      {
+        std::unique_lock<std::mutex> lock{mtx_};
+        for (; produced < batch.size(); ++produced)
+        {
+          if (capacity_ > 0 && size_locked() >= capacity_)
+          {
+            if (overflow_policy_ == OverflowPolicy::DROP_NEWEST)
+            {
+              break;
+            }
+            if (overflow_policy_ == OverflowPolicy::DROP_OLDEST)
+            {
+              evicted.emplace_back();
+              pop_oldest_locked(evicted.back());
+              dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+              if (produced > 0)
+              {
+                // Let consumers take what is already queued.
+                cv_.notify_all();
+                notify_external();
+              }
+              not_full_cv_.wait(lock, [this]
+                                { return size_locked() < capacity_ || closed_; });
+            }
+          }
+          if (closed_)
+          {
+            break;
+          }
+          push_locked(std::move(batch[produced]));
+        }
+        if (produced > 0)
+        {
+          cv_.notify_all();
+        }
+      }
+      bool dropped = !closed_.load();
+      for (size_t i = produced; i < batch.size(); ++i)
+      {
+        if (dropped)
+        {
+          dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+        channel_entry_rejected(batch[i], dropped);
+      }
+      for (auto &x : evicted)
+      {
+        discard_channel_entry(x);
+      }
+      if (produced > 0)
+      {
+        notify_external();
+        // Same handshake with a switch to direct dispatch as in produce().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (direct_dispatch_.load(std::memory_order_relaxed))
+        {
+          move_queued_to_ready();
+        }
+      }
+      return produced;
+    }
+
+    // In direct dispatch an entry is not queued; the ChannelCallback's ready count is bumped
+    // instead and the external notifier is signalled. Used by StaticSingleThreadedExecutor,
+    // which polls a fixed table of callbacks. Capacity and overflow policy do not apply.
+    // Entries already queued are converted when enabling. When disabling, the caller must
+    // requeue the ready counts it knows about (take_ready() then produce()).
+    void set_direct_dispatch(bool enable)
+    {
+      direct_dispatch_.store(enable);
+      if (enable)
+      {
+        move_queued_to_ready();
+      }
+    }
+
+    // Queues an entry that was already produced once (e.g. handed back from direct dispatch)
+    // without stamping it again.
+    bool requeue(T &&x)
+    {
+      return enqueue(x);
+    }
+
+    bool is_direct_dispatch() const
+    {
+      return direct_dispatch_.load();
+    }
+
     bool consume(T &x)
     {
+      if (ring_)
+      {
+        return consume_lock_free(x);
+      }
+
       std::unique_lock<std::mutex> lock{mtx_};
       cv_.wait(lock, [this]
-               { return !queue_.empty() || closed_; });
-      if (closed_ && queue_.empty())
+               { return size_locked() > 0 || closed_; });
+      if (closed_ && size_locked() == 0)
       {
         return false;
       }
-      x = std::move(queue_.front());
-      queue_.pop();
+      pop_locked(x);
+      notify_not_full();
       return true;
     }
 
     bool consume_nowait(T &x)
     {
+      if (ring_)
+      {
+        if (!ring_->pop(x))
+        {
+          return false;
+        }
+        notify_ring_not_full();
+        return true;
+      }
+
       std::lock_guard<std::mutex> lock{mtx_};
 
-      if (queue_.empty())
+      if (size_locked() == 0)
       {
         return false;
       }
 
-      x = std::move(queue_.front());
-      queue_.pop();
+      pop_locked(x);
+      notify_not_full();
       return true;
     }
 
-    void close()
+    // Moves up to max pending entries into buffer (appended) under a single lock acquisition.
+    // Returns the number of entries moved.
+    size_t drain_into(std::vector<T> &buffer, size_t max = std::numeric_limits<size_t>::max())
     {
+      size_t drained = 0;
+      if (ring_)
+      {
+        T x{};
+        while (drained < max && ring_->pop(x))
+        {
+          buffer.push_back(std::move(x));
+          ++drained;
+        }
+        if (drained > 0)
+        {
+          notify_ring_not_full();
+        }
+        return drained;
+      }
+
       std::lock_guard<std::mutex> lock{mtx_};
-      closed_ = true;
-      cv_.notify_all();
+      T x{};
+      while (drained < max && size_locked() > 0)
+      {
+        pop_locked(x);
+        buffer.push_back(std::move(x));
+        ++drained;
+      }
+      if (drained > 0 && capacity_ > 0 && overflow_policy_ == OverflowPolicy::BLOCK)
+      {
+        not_full_cv_.notify_all();
+      }
+      return drained;
+    }
+
+    // Blocks until at least one entry is pending, then moves every pending entry into buffer.
+    // Returns false once the channel is closed and empty.
+    bool consume_all(std::vector<T> &buffer)
+    {
+      if (ring_)
+      {
+        T x{};
+        if (!consume_lock_free(x))
+        {
+          return false;
+        }
+        buffer.push_back(std::move(x));
+        drain_into(buffer);
+        return true;
+      }
+
+      std::unique_lock<std::mutex> lock{mtx_};
+      cv_.wait(lock, [this]
+               { return size_locked() > 0 || closed_; });
+      if (closed_ && size_locked() == 0)
+      {
+        return false;
+      }
+      T x{};
+      while (size_locked() > 0)
+      {
+        pop_locked(x);
+        buffer.push_back(std::move(x));
+      }
+      if (capacity_ > 0 && overflow_policy_ == OverflowPolicy::BLOCK)
+      {
+        not_full_cv_.notify_all();
+      }
+      return true;
+    }
+
+    void close()
+    {
+      {
+        std::lock_guard<std::mutex> lock{mtx_};
+        closed_ = true;
+        cv_.notify_all();
+        not_full_cv_.notify_all();
+      }
+      notify_external();
+    }
+
+    // Additionally signal notifier whenever an entry is queued or the channel is closed.
+    // The notifier must outlive the channel or be reset to nullptr first.
+    void set_notifier(EventNotifier *notifier)
+    {
+      notifier_.store(notifier, std::memory_order_release);
     }
 
     bool is_closed()
     {
+      return closed_.load();
+    }
+
+    // Approximate for LOCK_FREE_RING while producers are active.
+    bool empty()
+    {
+      if (ring_)
+      {
+        return ring_->empty();
+      }
       std::lock_guard<std::mutex> lock{mtx_};
-      return closed_;
+      return size_locked() == 0;
+    }
+
+    ChannelType get_type() const
+    {
+      return type_;
+    }
+
+    bool is_priority_dispatch() const
+    {
+      return priority_dispatch_;
+    }
+
+    // Largest batch a consumer should drain at once. With priority dispatch it is 1 so an
+    // entry queued while a batch runs can still overtake lower-priority work.
+    size_t get_batch_limit() const
+    {
+      return priority_dispatch_ ? 1 : std::numeric_limits<size_t>::max();
+    }
+
+    // 0 when unbounded.
+    size_t get_capacity() const
+    {
+      return capacity_;
+    }
+
+    // Entries evicted or rejected because the channel was full.
+    uint64_t get_dropped_count() const
+    {
+      return dropped_count_.load(std::memory_order_relaxed);
     }
 
   private:
+    bool produce_entry(T &x, bool may_block)
+    {
+      channel_entry_produced(x);
+      if (direct_dispatch_.load() && !closed_.load() && produce_direct(x))
+      {
+        return true;
+      }
+      if (!enqueue(x, may_block))
+      {
+        // enqueue only moves from x on success.
+        channel_entry_rejected(x, !closed_.load());
+        return false;
+      }
+      // A static executor may have switched the channel to direct dispatch while x was being
+      // queued; whichever side sees the other moves the queued entries to their callbacks.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (direct_dispatch_.load(std::memory_order_relaxed))
+      {
+        move_queued_to_ready();
+      }
+      return true;
+    }
+
+    bool produce_direct(T &x)
+    {
+      if (!channel_entry_mark_ready(x))
+      {
+        return false;
+      }
+      if (direct_dispatch_.load())
+      {
+        notify_external();
+        return true;
+      }
+      // Switched back to queueing meanwhile: requeue whatever the executor did not reclaim.
+      for (uint32_t n = channel_entry_take_ready(x); n > 0; --n)
+      {
+        T entry = x;
+        enqueue(entry);
+      }
+      return true;
+    }
+
+    void move_queued_to_ready()
+    {
+      T x{};
+      bool moved = false;
+      while (consume_nowait(x))
+      {
+        channel_entry_mark_ready(x);
+        moved = true;
+      }
+      if (moved)
+      {
+        notify_external();
+      }
+    }
+
+    // Queues x (moving from it) under the capacity and overflow policy. Without may_block a
+    // full BLOCK channel rejects x.
+    bool enqueue(T &x, bool may_block = true)
+    {
+      if (ring_)
+      {
+        return produce_lock_free(x, may_block);
+      }
+
+      T evicted{};
+      bool has_evicted = false;
+      {
+        std::unique_lock<std::mutex> lock{mtx_};
+        if (capacity_ > 0 && size_locked() >= capacity_)
+        {
+          switch (overflow_policy_)
+          {
+          case OverflowPolicy::BLOCK:
+            if (!may_block)
+            {
+              dropped_count_.fetch_add(1, std::memory_order_relaxed);
+              return false;
+            }
+            not_full_cv_.wait(lock, [this]
+                              { return size_locked() < capacity_ || closed_; });
+            break;
+          case OverflowPolicy::DROP_OLDEST:
+            pop_oldest_locked(evicted);
+            has_evicted = true;
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            break;
+          case OverflowPolicy::DROP_NEWEST:
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+        }
+        if (closed_)
+        {
+          return false;
+        }
+        push_locked(std::move(x));
+        cv_.notify_all();
+      }
+      if (has_evicted)
+      {
+        discard_channel_entry(evicted);
+      }
+      notify_external();
+      return true;
+    }
+
+    struct PrioritizedEntry
+    {
+      T value;
+      std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct PriorityLevel
+    {
+      int priority;
+      std::deque<PrioritizedEntry> entries;
+    };
+
+    size_t size_locked() const
+    {
+      return priority_dispatch_ ? prioritized_size_ : queue_.size();
+    }
+
+    void push_locked(T &&x)
+    {
+      if (!priority_dispatch_)
+      {
+        queue_.push(std::forward<T>(x));
+        return;
+      }
+      int priority = channel_entry_priority(x);
+      // levels_ is kept sorted by descending priority; there are only a handful of levels.
+      auto it = levels_.begin();
+      while (it != levels_.end() && it->priority > priority)
+      {
+        ++it;
+      }
+      if (it == levels_.end() || it->priority != priority)
+      {
+        it = levels_.insert(it, PriorityLevel{priority, {}});
+      }
+      it->entries.push_back(PrioritizedEntry{std::forward<T>(x), std::chrono::steady_clock::now()});
+      ++prioritized_size_;
+    }
+
+    // Requires size_locked() > 0.
+    void pop_locked(T &x)
+    {
+      if (!priority_dispatch_)
+      {
+        x = std::move(queue_.front());
+        queue_.pop();
+        return;
+      }
+      PriorityLevel *best = nullptr;
+      if (priority_aging_period_.count() > 0)
+      {
+        // Each level's head is its oldest entry, so comparing heads is enough.
+        auto now = std::chrono::steady_clock::now();
+        int64_t best_effective = 0;
+        for (auto &level : levels_)
+        {
+          if (level.entries.empty())
+          {
+            continue;
+          }
+          int64_t effective = level.priority + (now - level.entries.front().enqueued) / priority_aging_period_;
+          if (!best || effective > best_effective)
+          {
+            best = &level;
+            best_effective = effective;
+          }
+        }
+      }
+      else
+      {
+        for (auto &level : levels_)
+        {
+          if (!level.entries.empty())
+          {
+            best = &level;
+            break;
+          }
+        }
+      }
+      x = std::move(best->entries.front().value);
+      best->entries.pop_front();
+      --prioritized_size_;
+    }
+
+    // Requires size_locked() > 0.
+    void pop_oldest_locked(T &x)
+    {
+      if (!priority_dispatch_)
+      {
+        pop_locked(x);
+        return;
+      }
+      PriorityLevel *oldest = nullptr;
+      for (auto &level : levels_)
+      {
+        if (!level.entries.empty() && (!oldest || level.entries.front().enqueued < oldest->entries.front().enqueued))
+        {
+          oldest = &level;
+        }
+      }
+      x = std::move(oldest->entries.front().value);
+      oldest->entries.pop_front();
+      --prioritized_size_;
+    }
+
+    void notify_external()
+    {
+      EventNotifier *notifier = notifier_.load(std::memory_order_acquire);
+      if (notifier)
+      {
+        notifier->notify();
+      }
+    }
+
+    void notify_not_full()
+    {
+      if (capacity_ > 0 && overflow_policy_ == OverflowPolicy::BLOCK)
+      {
+        not_full_cv_.notify_one();
+      }
+    }
+
+    // Wakes producers parked on a full ring by produce_lock_free. Pairs with the fence there:
+    // either the producer sees the freed slot on its re-check, or we see it parked.
+    void notify_ring_not_full()
+    {
+      if (overflow_policy_ != OverflowPolicy::BLOCK)
+      {
+        return;
+      }
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (parked_producers_.load(std::memory_order_relaxed) > 0)
+      {
+        std::lock_guard<std::mutex> lock{mtx_};
+        not_full_cv_.notify_all();
+      }
+    }
+
+    bool produce_lock_free(T &x, bool may_block)
+    {
+      // A full BLOCK ring is retried this many times before the producer parks on not_full_cv_.
+      constexpr int kBlockSpins = 64;
+      int spins = 0;
+      while (!ring_->push(x))
+      {
+        if (closed_.load(std::memory_order_acquire))
+        {
+          return false;
+        }
+        if (overflow_policy_ == OverflowPolicy::DROP_NEWEST)
+        {
+          dropped_count_.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        if (overflow_policy_ == OverflowPolicy::DROP_OLDEST)
+        {
+          T evicted{};
+          if (ring_->pop(evicted))
+          {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            discard_channel_entry(evicted);
+          }
+          continue;
+        }
+        if (!may_block)
+        {
+          dropped_count_.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        if (++spins < kBlockSpins)
+        {
+          std::this_thread::yield();
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock{mtx_};
+        parked_producers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool pushed = ring_->push(x);
+        if (!pushed && !closed_)
+        {
+          not_full_cv_.wait(lock);
+        }
+        parked_producers_.fetch_sub(1, std::memory_order_relaxed);
+        if (pushed)
+        {
+          break;
+        }
+      }
+
+      // Pairs with the fence in consume_lock_free: either the consumer sees the new entry
+      // on its re-check, or we see it parked and take the mutex to wake it.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (parked_consumers_.load(std::memory_order_relaxed) > 0)
+      {
+        std::lock_guard<std::mutex> lock{mtx_};
+        cv_.notify_all();
+      }
+      notify_external();
+      return true;
+    }
+
+    bool consume_lock_free(T &x)
+    {
+      for (;;)
+      {
+        if (ring_->pop(x))
+        {
+          notify_ring_not_full();
+          return true;
+        }
+
+        std::unique_lock<std::mutex> lock{mtx_};
+        parked_consumers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool popped = ring_->pop(x);
+        if (!popped && !closed_)
+        {
+          cv_.wait(lock);
+        }
+        parked_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        if (popped)
+        {
+          lock.unlock();
+          notify_ring_not_full();
+          return true;
+        }
+        if (closed_ && ring_->empty())
+        {
+          return false;
+        }
+      }
+    }
+
+    const ChannelType type_;
+    size_t capacity_;
+    const OverflowPolicy overflow_policy_;
+    const bool priority_dispatch_;
+    const std::chrono::nanoseconds priority_aging_period_;
     std::queue<T> queue_;
-    bool closed_ = false;
+    std::vector<PriorityLevel> levels_; // Used instead of queue_ with priority dispatch.
+    size_t prioritized_size_{0};
+    std::unique_ptr<LockFreeRingBuffer<T>> ring_;
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> direct_dispatch_{false};
+    std::atomic<int> parked_consumers_{0};
+    std::atomic<int> parked_producers_{0}; // Blocked on a full ring (OverflowPolicy::BLOCK).
+    std::atomic<uint64_t> dropped_count_{0};
+    std::atomic<EventNotifier *> notifier_{nullptr};
     std::mutex mtx_;
     std::condition_variable cv_;
+    std::condition_variable not_full_cv_;
   };
 } // namespace lwrcl
 
@@ -21,11 +21,18 @@
 #include <fastdds/dds/core/status/SubscriptionMatchedStatus.hpp>
 
 #include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include <fastdds/dds/core/LoanableSequence.hpp>
 #include <fastdds/dds/core/policy/QosPolicies.hpp>
 #include <fastdds/dds/core/status/StatusMask.hpp>
+#include <fastdds/dds/common/InstanceHandle.hpp>
+#include <fastdds/dds/core/condition/Condition.hpp>
+#include <fastdds/dds/core/condition/GuardCondition.hpp>
+#include <fastdds/dds/core/condition/WaitSet.hpp>
+#include <fastdds/dds/subscriber/ReadCondition.hpp>
 
 #include <fastdds/dds/topic/TypeSupport.hpp>
 #include <fastdds/dds/topic/Topic.hpp>
+#include <fastdds/dds/topic/ContentFilteredTopic.hpp>
 #include <fastdds/dds/topic/TopicDataType.hpp>
 #include <fastdds/dds/topic/TopicDescription.hpp>
 #include <fastdds/dds/topic/qos/TopicQos.hpp>
@@ -67,10 +74,26 @@ namespace lwrcl
     using SubscriptionMatchedStatus = eprosima::fastdds::dds::SubscriptionMatchedStatus;
 
     using SampleInfo = eprosima::fastdds::dds::SampleInfo;
+    using SampleInfoSeq = eprosima::fastdds::dds::SampleInfoSeq;
+    template <typename T>
+    using LoanableSequence = eprosima::fastdds::dds::LoanableSequence<T>;
     using StatusMask = eprosima::fastdds::dds::StatusMask;
+    using InstanceHandle_t = eprosima::fastdds::dds::InstanceHandle_t;
+
+    using Condition = eprosima::fastdds::dds::Condition;
+    using ConditionSeq = eprosima::fastdds::dds::ConditionSeq;
+    using GuardCondition = eprosima::fastdds::dds::GuardCondition;
+    using ReadCondition = eprosima::fastdds::dds::ReadCondition;
+    using WaitSet = eprosima::fastdds::dds::WaitSet;
+    static const eprosima::fastdds::dds::SampleStateKind NOT_READ_SAMPLE_STATE =
+        eprosima::fastdds::dds::NOT_READ_SAMPLE_STATE;
+    static const eprosima::fastdds::dds::ViewStateMask ANY_VIEW_STATE = eprosima::fastdds::dds::ANY_VIEW_STATE;
+    static const eprosima::fastdds::dds::InstanceStateMask ANY_INSTANCE_STATE =
+        eprosima::fastdds::dds::ANY_INSTANCE_STATE;
 
     using TypeSupport = eprosima::fastdds::dds::TypeSupport;
     using Topic = eprosima::fastdds::dds::Topic;
+    using ContentFilteredTopic = eprosima::fastdds::dds::ContentFilteredTopic;
     using RegisterdTopics = std::unordered_map<std::string, eprosima::fastdds::dds::Topic *>;
     using TopicDataType = eprosima::fastdds::dds::TopicDataType;
     using TopicDescription = eprosima::fastdds::dds::TopicDescription;
@@ -94,6 +117,11 @@ namespace lwrcl
         eprosima::fastdds::dds::BEST_EFFORT_RELIABILITY_QOS;
     static const ReliabilityQosPolicyKind RELIABLE_RELIABILITY_QOS =
         eprosima::fastdds::dds::RELIABLE_RELIABILITY_QOS;
+    using HistoryQosPolicyKind = eprosima::fastdds::dds::HistoryQosPolicyKind;
+    static const HistoryQosPolicyKind KEEP_LAST_HISTORY_QOS =
+        eprosima::fastdds::dds::KEEP_LAST_HISTORY_QOS;
+    static const HistoryQosPolicyKind KEEP_ALL_HISTORY_QOS =
+        eprosima::fastdds::dds::KEEP_ALL_HISTORY_QOS;
   }
 
   namespace rtps
@@ -0,0 +1,124 @@
+#ifndef LWRCL_INTRA_PROCESS_HPP_
+#define LWRCL_INTRA_PROCESS_HPP_
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fast_dds_header.hpp"
+
+namespace lwrcl
+{
+
+  // Subscription side of intra-process delivery, registered with an IntraProcessTopic.
+  class IntraProcessSubscriptionBase
+  {
+  public:
+    virtual ~IntraProcessSubscriptionBase() = default;
+    // Handle of the subscription's DataReader, to tell local readers from remote ones.
+    virtual dds::InstanceHandle_t get_reader_handle() const = 0;
+  };
+
+  template <typename T>
+  class IntraProcessSubscription : public IntraProcessSubscriptionBase
+  {
+  public:
+    // Runs on the publishing thread under the topic lock, so it must not block. Only an
+    // exclusive message, read by no other subscription nor the publisher, may be modified.
+    virtual void deliver(const std::shared_ptr<T> &message, bool exclusive) = 0;
+  };
+
+  // Intra-process publishers and subscriptions of one topic within one participant. Publishers
+  // hand their messages to the registered subscriptions as shared pointers and only write to
+  // DDS while a matched reader is not one of them. Subscriptions drop the DDS copies of samples
+  // from the registered writers, which they already received directly.
+  class IntraProcessTopic
+  {
+  public:
+    void add_subscription(IntraProcessSubscriptionBase *subscription)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      subscriptions_.push_back(subscription);
+    }
+
+    // No delivery reaches subscription after this returns.
+    void remove_subscription(IntraProcessSubscriptionBase *subscription)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      subscriptions_.erase(std::remove(subscriptions_.begin(), subscriptions_.end(), subscription),
+                           subscriptions_.end());
+    }
+
+    void add_writer(const dds::InstanceHandle_t &writer)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      writers_.push_back(writer);
+    }
+
+    void remove_writer(const dds::InstanceHandle_t &writer)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      writers_.erase(std::remove(writers_.begin(), writers_.end(), writer), writers_.end());
+    }
+
+    bool has_subscriptions()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return !subscriptions_.empty();
+    }
+
+    // Whether a sample was written by an intra-process publisher of this topic.
+    bool is_local_writer(const dds::InstanceHandle_t &writer)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return std::find(writers_.begin(), writers_.end(), writer) != writers_.end();
+    }
+
+    // Whether any of the readers matched by a writer is not an intra-process subscription.
+    bool has_remote_reader(const std::vector<dds::InstanceHandle_t> &matched_readers)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto &reader : matched_readers)
+      {
+        bool local = std::any_of(subscriptions_.begin(), subscriptions_.end(),
+                                 [&reader](IntraProcessSubscriptionBase *subscription)
+                                 { return subscription->get_reader_handle() == reader; });
+        if (!local)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Subscriptions of another message type sharing the topic name are skipped. publisher_reads
+    // is set when the publisher still writes message to DDS after this returns.
+    template <typename T>
+    void deliver(const std::shared_ptr<T> &message, bool publisher_reads)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      bool exclusive = !publisher_reads && subscriptions_.size() == 1;
+      for (auto subscription : subscriptions_)
+      {
+        auto typed = dynamic_cast<IntraProcessSubscription<T> *>(subscription);
+        if (typed)
+        {
+          typed->deliver(message, exclusive);
+        }
+      }
+    }
+
+    // The topic shared by every intra-process endpoint of topic in participant.
+    static std::shared_ptr<IntraProcessTopic> get(dds::DomainParticipant *participant, const std::string &topic);
+
+  private:
+    std::mutex mutex_;
+    std::vector<IntraProcessSubscriptionBase *> subscriptions_;
+    std::vector<dds::InstanceHandle_t> writers_;
+  };
+
+} // namespace lwrcl
+
+#endif // LWRCL_INTRA_PROCESS_HPP_
@@ -5,6 +5,7 @@
 #include <string>
 #include <unordered_map>
 #include <forward_list>
+#include <deque>
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -13,6 +14,7 @@
 #include <cstring>
 #include <iostream>
 #include <atomic>
+#include <condition_variable>
 
 #include "fast_dds_header.hpp"
 #include "signal_handler.hpp"
@@ -20,52 +22,157 @@
 #include "publisher.hpp"
 #include "subscriber.hpp"
 #include "timer.hpp"
+#include "callback_group.hpp"
+#include "thread_config.hpp"
+#include "time_source.hpp"
+#include "qos.hpp"
+#include "synchronizer.hpp"
 
 namespace lwrcl
 {
 
   class Clock;
 
+  // Per-node construction options.
+  struct NodeOptions
+  {
+    ChannelOptions channel_options; // Backend, capacity and overflow policy of each callback group's channel.
+    bool enable_statistics = true;   // Per-callback queue wait, execution time, invocation and drop counters.
+    // When positive, a node thread prints the statistics to std::cout at this period.
+    std::chrono::milliseconds statistics_dump_period{0};
+    // Clock returned by get_clock(). With ROS_TIME, create_timer timers follow simulated time
+    // as well; otherwise they fire on the steady clock.
+    ClockType clock_type = ClockType::SYSTEM_TIME;
+    // Publishers and subscriptions of nodes sharing a participant exchange messages as shared
+    // pointers instead of through DDS; remote readers are still served by DDS. Both nodes
+    // need it enabled.
+    bool use_intra_process_comms = false;
+  };
+
   class Node
   {
   public:
-    Node(int domain_id);
-    Node(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant);
+    Node(int domain_id, const NodeOptions &options = NodeOptions());
+    Node(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant, const NodeOptions &options = NodeOptions());
     virtual ~Node();
     std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> get_participant() const;
 
     template <typename T>
     Publisher<T> *create_publisher(MessageType *message_type, const std::string &topic, const dds::TopicQos &qos)
     {
-      auto publisher = std::make_unique<Publisher<T>>(participant_.get(), message_type, std::string("rt/") + topic, qos);
+      auto publisher = std::make_unique<Publisher<T>>(participant_.get(), message_type, std::string("rt/") + topic, qos,
+                                                      QoS(), options_.use_intra_process_comms);
       Publisher<T> *raw_ptr = publisher.get();
       publisher_list_.push_front(std::move(publisher));
       return raw_ptr;
     }
 
+    // Writer reliability, durability and history come from qos (see SensorDataQoS and friends).
+    template <typename T>
+    Publisher<T> *create_publisher(MessageType *message_type, const std::string &topic, const QoS &qos)
+    {
+      auto publisher = std::make_unique<Publisher<T>>(participant_.get(), message_type, std::string("rt/") + topic,
+                                                      dds::TOPIC_QOS_DEFAULT, qos, options_.use_intra_process_comms);
+      Publisher<T> *raw_ptr = publisher.get();
+      publisher_list_.push_front(std::move(publisher));
+      return raw_ptr;
+    }
+
+    // callback_function takes T *, std::unique_ptr<T> or std::shared_ptr<const T> (see
+    // AnySubscriptionCallback). callback_group must have been created by this node; nullptr
+    // selects the default group.
     template <typename T>
     Subscriber<T> *create_subscription(MessageType *message_type, const std::string &topic, const dds::TopicQos &qos,
-                                       std::function<void(T *)> callback_function)
+                                       AnySubscriptionCallback<T> callback_function, CallbackGroup *callback_group = nullptr,
+                                       const SubscriptionOptions &options = SubscriptionOptions())
     {
-      auto subscriber = std::make_unique<Subscriber<T>>(participant_.get(), message_type, std::string("rt/") + topic, qos, callback_function, channel_);
+      CallbackGroup *group = resolve_callback_group(callback_group);
+      auto subscriber = std::make_unique<Subscriber<T>>(participant_.get(), message_type, std::string("rt/") + topic, qos, callback_function,
+                                                        group->get_channel(), options, QoS(), options_.use_intra_process_comms);
       Subscriber<T> *raw_ptr = subscriber.get();
+      register_callback(group, raw_ptr->get_channel_callback(), topic);
       subscription_list_.push_front(std::move(subscriber));
+      if (options.wait_set)
+      {
+        add_wait_set_subscription(raw_ptr);
+      }
       return raw_ptr;
     }
 
+    // Reader reliability, durability and history come from qos (see SensorDataQoS and friends).
     template <typename T>
-    Timer<T> *create_timer(T period, std::function<void()> callback_function)
+    Subscriber<T> *create_subscription(MessageType *message_type, const std::string &topic, const QoS &qos,
+                                       AnySubscriptionCallback<T> callback_function, CallbackGroup *callback_group = nullptr,
+                                       const SubscriptionOptions &options = SubscriptionOptions())
     {
-      auto timer = std::make_unique<Timer<T>>(period, callback_function, channel_);
+      CallbackGroup *group = resolve_callback_group(callback_group);
+      auto subscriber = std::make_unique<Subscriber<T>>(participant_.get(), message_type, std::string("rt/") + topic,
+                                                        dds::TOPIC_QOS_DEFAULT, callback_function, group->get_channel(),
+                                                        options, qos, options_.use_intra_process_comms);
+      Subscriber<T> *raw_ptr = subscriber.get();
+      register_callback(group, raw_ptr->get_channel_callback(), topic);
+      subscription_list_.push_front(std::move(subscriber));
+      if (options.wait_set)
+      {
+        add_wait_set_subscription(raw_ptr);
+      }
+      return raw_ptr;
+    }
+
+    template <typename T>
+    Timer<T> *create_timer(T period, std::function<void()> callback_function, CallbackGroup *callback_group = nullptr)
+    {
+      CallbackGroup *group = resolve_callback_group(callback_group);
+      auto timer = std::make_unique<Timer<T>>(period, callback_function, group->get_channel(), options_.clock_type);
       Timer<T> *raw_ptr = timer.get();
+      register_callback(group, raw_ptr->get_channel_callback(),
+                        "timer(" + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(period).count()) + "us)");
       timer_list_.push_front(std::move(timer));
       return raw_ptr;
     }
+
+    // Subscribes to the /clock topic and activates simulated time, so ROS_TIME clocks, timers and
+    // Rates follow it. ClockMessage is the application's rosgraph_msgs::msg::Clock type; only
+    // clock().sec() and clock().nanosec() are used. Simulated time only advances when this
+    // callback runs, so serve it from an executor that is not starved by long callbacks.
+    template <typename ClockMessage>
+    Subscriber<ClockMessage> *create_clock_subscription(MessageType *message_type, const QoS &qos = ClockQoS(),
+                                                        CallbackGroup *callback_group = nullptr)
+    {
+      TimeSource::set_simulated_time(true);
+      return create_subscription<ClockMessage>(
+          message_type, "clock", qos, [](ClockMessage *message)
+          { TimeSource::set_ros_time(static_cast<int64_t>(message->clock().sec()) * 1000000000 + message->clock().nanosec()); },
+          callback_group);
+    }
+
+    CallbackGroup *create_callback_group(CallbackGroupType type);
+    CallbackGroup *get_default_callback_group();
+
+    // Calls f(CallbackGroup *) for every group of the node, the default group first.
+    template <typename F>
+    void for_each_callback_group(F f)
+    {
+      std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+      for (auto &group : callback_groups_)
+      {
+        f(group.get());
+      }
+    }
+
     virtual void spin();
     virtual void spin_some();
     virtual void stop_spin();
     virtual void shutdown();
     virtual Clock *get_clock();
+    // Callbacks evicted or rejected by a bounded channel (see ChannelOptions::overflow_policy).
+    uint64_t get_dropped_callback_count();
+    // Used by executors to be woken when this node has work; nullptr detaches.
+    void set_event_notifier(EventNotifier *notifier);
+    bool has_pending_callbacks();
+    // One entry per subscription and timer, in callback group and creation order.
+    std::vector<CallbackStatisticsSnapshot> get_statistics();
+    void dump_statistics(std::ostream &out);
 
   private:
     struct DomainParticipantDeleter
@@ -79,12 +186,26 @@ namespace lwrcl
         }
     };
 
+    CallbackGroup *resolve_callback_group(CallbackGroup *callback_group);
+    void register_callback(CallbackGroup *group, ChannelCallback *callback, const std::string &name);
+    void add_wait_set_subscription(ISubscriber *subscription);
+    void start_statistics_dump();
+
     std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant_;
+    NodeOptions options_;
+    std::vector<std::unique_ptr<CallbackGroup>> callback_groups_; // [0] is the default group.
+    std::mutex callback_groups_mutex_;
+    EventNotifier *event_notifier_{nullptr}; // Executor notifier, applied to groups created later.
+    EventNotifier spin_notifier_;            // Used by spin() with several groups or wait-set subscriptions.
     std::forward_list<std::unique_ptr<IPublisher>> publisher_list_;
     std::forward_list<std::unique_ptr<ISubscriber>> subscription_list_;
+    std::vector<ISubscriber *> wait_set_subscriptions_; // Guarded by callback_groups_mutex_.
     std::forward_list<std::unique_ptr<ITimer>> timer_list_;
-    Channel<ChannelCallback *> channel_;
     std::unique_ptr<Clock> clock_;
+    std::thread statistics_dump_thread_;
+    std::mutex statistics_dump_mutex_;
+    std::condition_variable statistics_dump_cv_;
+    bool statistics_dump_stop_{false};
   };
 
   // lwrcl state
@@ -105,15 +226,21 @@ namespace lwrcl
     void shutdown();
 
   private:
-    std::vector<Node *> nodes_; // List of nodes managed by the executor.
-    std::mutex mutex_;          // Mutex for thread-safe access to the nodes list.
+    std::vector<Node *> nodes_;       // List of nodes managed by the executor.
+    std::mutex mutex_;                // Mutex for thread-safe access to the nodes list.
+    EventNotifier notifier_;          // Signalled by every node channel; spin() blocks on it while idle.
+    std::atomic<bool> stop_flag_{false};
   };
 
-  // Executor that manages and executes nodes, each in its own thread, allowing for parallel processing.
+  // Executor that runs the callbacks of all its nodes on a fixed pool of worker threads.
+  // Each worker keeps a deque of ready work and steals from the other workers when its own
+  // runs dry. A MutuallyExclusive callback group is claimed by one worker while its callbacks
+  // run; callbacks of a Reentrant group are scheduled one by one and may run in parallel.
   class MultiThreadedExecutor
   {
   public:
-    MultiThreadedExecutor();
+    // number_of_threads == 0 uses std::thread::hardware_concurrency().
+    explicit MultiThreadedExecutor(size_t number_of_threads = 0);
     ~MultiThreadedExecutor();
 
     void add_node(Node *node);
@@ -122,11 +249,78 @@ namespace lwrcl
     void spin();
     void spin_some();
     void shutdown();
+    size_t get_number_of_threads() const;
+    // Scheduling of the worker threads, applied when spin() starts them.
+    // Defaults to get_default_thread_config() at construction.
+    void set_thread_config(const ThreadConfig &config);
 
   private:
-    std::vector<Node *> nodes_;        // List of nodes managed by the executor.
-    std::vector<std::thread> threads_; // Threads created for each node for parallel execution.
-    std::mutex mutex_;                 // Mutex for thread-safe access to the nodes and threads lists.
+    // Either a claimed MutuallyExclusive group to run until empty (callback == nullptr),
+    // or a single callback of a Reentrant group.
+    struct Task
+    {
+      CallbackGroup *group;
+      ChannelCallback *callback;
+    };
+
+    struct WorkQueue
+    {
+      std::deque<Task> tasks; // Owner pushes/pops at the back, thieves take from the front.
+      std::mutex mutex;
+    };
+
+    void worker_loop(size_t index);
+    bool pop_task(size_t index, Task &task);
+    size_t collect_ready_work(size_t index);
+    void run_task(const Task &task);
+
+    size_t number_of_threads_;
+    std::vector<Node *> nodes_;                            // Nodes managed by the executor.
+    std::vector<std::unique_ptr<WorkQueue>> work_queues_;  // One per worker thread.
+    std::vector<std::thread> threads_;                     // Worker pool, alive during spin().
+    std::mutex mutex_;                                     // Guards nodes_ and thread_config_.
+    EventNotifier notifier_;                               // Signalled by every node channel; idle workers block on it.
+    std::atomic<bool> stop_flag_{false};
+    ThreadConfig thread_config_;
+  };
+
+  // Executor for fixed topologies. On the first spin it snapshots the subscriptions and timers
+  // of its nodes into a flat dispatch table and switches their channels to direct dispatch:
+  // arrivals only bump a per-callback ready count, and each cycle walks the table in a fixed
+  // order (nodes in add order, then groups, then creation order) without queueing or
+  // allocating. Entities created after the first spin are not picked up until nodes are
+  // added or removed again.
+  class StaticSingleThreadedExecutor
+  {
+  public:
+    StaticSingleThreadedExecutor();
+    ~StaticSingleThreadedExecutor();
+
+    void add_node(Node *node);
+    void remove_node(Node *node);
+    void stop_spin();
+    void spin();
+    void spin_some();
+    void shutdown();
+
+  private:
+    struct DispatchEntry
+    {
+      ChannelCallback *callback;
+      Channel<ChannelCallback *> *channel;
+    };
+
+    void build_dispatch_table();
+    void release_dispatch_table();
+    size_t execute_ready();
+
+    std::vector<Node *> nodes_;
+    std::vector<DispatchEntry> dispatch_table_;
+    std::vector<Channel<ChannelCallback *> *> channels_; // Channels switched to direct dispatch.
+    bool table_built_{false};
+    std::mutex mutex_;
+    EventNotifier notifier_;
+    std::atomic<bool> stop_flag_{false};
   };
 
   class Duration;
@@ -189,10 +383,7 @@ namespace lwrcl
   class Clock
   {
   public:
-    enum class ClockType
-    {
-      SYSTEM_TIME
-    };
+    using ClockType = lwrcl::ClockType;
 
   private:
     ClockType type_;
@@ -208,9 +399,14 @@ namespace lwrcl
   private:
     Duration period_;
     std::chrono::steady_clock::time_point next_time_;
+    int64_t next_ros_time_; // While simulated time is active.
+    ClockType clock_type_;
+    TimerBackendOptions backend_;
 
   public:
-    explicit Rate(const Duration &period);
+    explicit Rate(const Duration &period, const TimerBackendOptions &backend = TimerBackendOptions());
+    // A ROS_TIME Rate sleeps on simulated time while TimeSource has it active.
+    Rate(const Duration &period, ClockType clock_type, const TimerBackendOptions &backend = TimerBackendOptions());
     void sleep();
   };
 } // namespace lwrcl
@@ -1,10 +1,17 @@
 #ifndef LWRCL_PUBLISHER_HPP_
 #define LWRCL_PUBLISHER_HPP_
 
+#include <algorithm>
 #include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "fast_dds_header.hpp"
+#include "intra_process.hpp"
+#include "qos.hpp"
 namespace lwrcl
 {
 
@@ -14,9 +21,106 @@ namespace lwrcl
     void on_publication_matched(dds::DataWriter *, const dds::PublicationMatchedStatus &status) override
     {
       count = status.current_count;
+      std::lock_guard<std::mutex> lock(readers_mutex_);
+      if (status.current_count_change > 0)
+      {
+        matched_readers_.push_back(status.last_subscription_handle);
+      }
+      else if (status.current_count_change < 0)
+      {
+        matched_readers_.erase(
+            std::remove(matched_readers_.begin(), matched_readers_.end(), status.last_subscription_handle),
+            matched_readers_.end());
+      }
+    }
+
+    bool has_remote_reader(IntraProcessTopic &topic) const
+    {
+      std::lock_guard<std::mutex> lock(readers_mutex_);
+      return topic.has_remote_reader(matched_readers_);
     }
 
     std::atomic<int32_t> count{0};
+
+  private:
+    mutable std::mutex readers_mutex_;
+    std::vector<dds::InstanceHandle_t> matched_readers_;
+  };
+
+  template <typename T>
+  class Publisher;
+
+  // Message borrowed from a Publisher with borrow_loaned_message(), filled in place and handed
+  // back with publish(LoanedMessage&&). For a plain type the instance lives in the DataWriter's
+  // sample pool, so over data sharing it is written straight into the shared segment without
+  // a serialization or copy. Other types get a heap instance, published like a std::unique_ptr.
+  // An unpublished loan is returned on destruction; the message must not outlive its publisher.
+  template <typename T>
+  class LoanedMessage
+  {
+  public:
+    LoanedMessage(LoanedMessage &&other) noexcept
+        : writer_(other.writer_), message_(other.message_), owned_(std::move(other.owned_))
+    {
+      other.writer_ = nullptr;
+      other.message_ = nullptr;
+    }
+
+    LoanedMessage(const LoanedMessage &) = delete;
+    LoanedMessage &operator=(const LoanedMessage &) = delete;
+    LoanedMessage &operator=(LoanedMessage &&) = delete;
+
+    ~LoanedMessage()
+    {
+      discard();
+    }
+
+    T &get()
+    {
+      return *message_;
+    }
+
+    T *operator->()
+    {
+      return message_;
+    }
+
+    T &operator*()
+    {
+      return *message_;
+    }
+
+    // Whether the instance is DataWriter memory rather than a heap fallback.
+    bool is_loaned() const
+    {
+      return writer_ != nullptr;
+    }
+
+  private:
+    friend class Publisher<T>;
+
+    LoanedMessage(dds::DataWriter *writer, T *sample) : writer_(writer), message_(sample) {}
+
+    explicit LoanedMessage(std::unique_ptr<T> message) : message_(message.get()), owned_(std::move(message)) {}
+
+    // Gives the loan back unpublished.
+    void discard()
+    {
+      if (writer_ != nullptr)
+      {
+        void *sample = message_;
+        if (writer_->discard_loan(sample) != ReturnCode_t::RETCODE_OK)
+        {
+          std::cerr << "Error: Failed to discard a loaned message" << std::endl;
+        }
+        writer_ = nullptr;
+      }
+      message_ = nullptr;
+    }
+
+    dds::DataWriter *writer_{nullptr}; // Set while the message holds a loan.
+    T *message_{nullptr};
+    std::unique_ptr<T> owned_; // Heap fallback.
   };
 
   class IPublisher
@@ -29,8 +133,10 @@ namespace lwrcl
   class Publisher : public IPublisher
   {
   public:
+    // With intra_process, subscriptions of the same participant that also use intra-process
+    // communication receive the messages directly (see IntraProcessTopic).
     Publisher(dds::DomainParticipant *participant, MessageType *message_type, const std::string &topic,
-              const dds::TopicQos &qos)
+              const dds::TopicQos &qos, const QoS &endpoint_qos = QoS(), bool intra_process = false)
         : participant_(participant), message_type_(message_type), topic_(nullptr), publisher_(nullptr), writer_(nullptr)
     {
       if (message_type_->get_type_support().register_type(participant_) != ReturnCode_t::RETCODE_OK)
@@ -60,10 +166,7 @@ namespace lwrcl
       }
       dds::DataWriterQos writer_qos = dds::DATAWRITER_QOS_DEFAULT;
       writer_qos.endpoint().history_memory_policy = rtps::PREALLOCATED_WITH_REALLOC_MEMORY_MODE;
-      // writer_qos.data_sharing().automatic();
-      writer_qos.history().depth = 10;
-      writer_qos.reliability().kind = dds::RELIABLE_RELIABILITY_QOS;
-      // writer_qos.durability().kind = dds::TRANSIENT_LOCAL_DURABILITY_QOS;
+      endpoint_qos.apply(writer_qos);
       writer_qos.data_sharing().automatic();
       // writer_qos.data_sharing().on("shared_directory");
       writer_ = publisher_->create_datawriter(topic_, writer_qos, &listener_);
@@ -73,12 +176,21 @@ namespace lwrcl
         participant_->delete_topic(topic_);         // Cleanup on failure
         throw std::runtime_error("Failed to create datawriter");
       }
+      if (intra_process)
+      {
+        intra_process_topic_ = IntraProcessTopic::get(participant_, topic);
+        intra_process_topic_->add_writer(writer_->get_instance_handle());
+      }
     }
 
     ~Publisher()
     {
       if (writer_ != nullptr)
       {
+        if (intra_process_topic_)
+        {
+          intra_process_topic_->remove_writer(writer_->get_instance_handle());
+        }
         publisher_->delete_datawriter(writer_);
       }
       if (publisher_ != nullptr)
@@ -91,11 +203,92 @@ namespace lwrcl
       }
     }
 
+    // Intra-process subscriptions get a copy of message.
     void publish(T *message) const
     {
+      if (intra_process_topic_ && intra_process_topic_->has_subscriptions())
+      {
+        intra_process_topic_->deliver(std::make_shared<T>(*message), false);
+        if (!listener_.has_remote_reader(*intra_process_topic_))
+        {
+          return;
+        }
+      }
       writer_->write(message);
     }
 
+    // Intra-process subscriptions share message without a copy; it is only serialized when a
+    // reader outside them is matched.
+    void publish(std::unique_ptr<T> message) const
+    {
+      T *raw = message.get();
+      std::shared_ptr<T> shared(std::move(message));
+      if (intra_process_topic_ && intra_process_topic_->has_subscriptions())
+      {
+        // The DDS write below still reads the shared message.
+        bool remote = listener_.has_remote_reader(*intra_process_topic_);
+        intra_process_topic_->deliver(shared, remote);
+        if (!remote)
+        {
+          return;
+        }
+      }
+      writer_->write(raw);
+    }
+
+    // Whether borrow_loaned_message() lends DataWriter memory, which needs a plain type (no
+    // strings or unbounded sequences).
+    bool can_loan_messages() const
+    {
+      return message_type_->get_type_support()->is_plain();
+    }
+
+    // A message to fill in place, loaned from the DataWriter when the type allows it and the
+    // writer has a free sample, otherwise a fresh heap instance.
+    LoanedMessage<T> borrow_loaned_message() const
+    {
+      if (can_loan_messages())
+      {
+        void *sample = nullptr;
+        if (writer_->loan_sample(sample, dds::DataWriter::LoanInitializationKind::CONSTRUCTED_LOAN_INITIALIZATION) ==
+            ReturnCode_t::RETCODE_OK)
+        {
+          return LoanedMessage<T>(writer_, static_cast<T *>(sample));
+        }
+      }
+      return LoanedMessage<T>(std::make_unique<T>());
+    }
+
+    // Writes the loaned sample without a copy; intra-process subscriptions get a copy of it.
+    // A heap fallback is published like publish(std::unique_ptr<T>).
+    void publish(LoanedMessage<T> &&message) const
+    {
+      if (!message.is_loaned())
+      {
+        publish(std::move(message.owned_));
+        message.discard();
+        return;
+      }
+      if (intra_process_topic_ && intra_process_topic_->has_subscriptions())
+      {
+        intra_process_topic_->deliver(std::make_shared<T>(*message.message_), false);
+        if (!listener_.has_remote_reader(*intra_process_topic_))
+        {
+          message.discard();
+          return;
+        }
+      }
+      if (!writer_->write(message.message_))
+      {
+        std::cerr << "Error: Failed to publish a loaned message" << std::endl;
+        message.discard();
+        return;
+      }
+      // The write took the loan over.
+      message.writer_ = nullptr;
+      message.message_ = nullptr;
+    }
+
     int32_t get_subscriber_count()
     {
       return listener_.count;
@@ -108,6 +301,7 @@ namespace lwrcl
     dds::Publisher *publisher_;
     dds::DataWriter *writer_;
     PublisherListener listener_;
+    std::shared_ptr<IntraProcessTopic> intra_process_topic_;
   };
 } // namespace lwrcl
 
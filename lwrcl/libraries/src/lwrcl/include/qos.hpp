@@ -0,0 +1,161 @@
+#ifndef LWRCL_QOS_HPP_
+#define LWRCL_QOS_HPP_
+
+#include <cstddef>
+#include <string>
+
+#include "fast_dds_header.hpp"
+
+namespace lwrcl
+{
+
+  enum class ReliabilityPolicy
+  {
+    RELIABLE,   // Lost samples are retransmitted.
+    BEST_EFFORT // Lost samples stay lost; no acknowledgements, lowest latency.
+  };
+
+  enum class DurabilityPolicy
+  {
+    SYSTEM_DEFAULT, // Left as Fast DDS sets it: transient local for writers, volatile for readers.
+    VOLATILE,       // Only samples published after a reader matched are delivered to it.
+    TRANSIENT_LOCAL // The writer keeps its history for readers that join later.
+  };
+
+  enum class HistoryPolicy
+  {
+    KEEP_LAST, // Keep the newest depth samples.
+    KEEP_ALL   // Keep every sample up to the resource limits.
+  };
+
+  // Writer and reader QoS of one publisher or subscription, modelled on rclcpp::QoS. The
+  // default is the profile lwrcl endpoints always had: reliable, keep last 10, and the Fast DDS
+  // durability (transient local writers, volatile readers, so late joiners can ask for history).
+  // Readers only match writers offering at least their reliability and durability.
+  class QoS
+  {
+  public:
+    explicit QoS(size_t depth = 10) : depth_(depth) {}
+
+    QoS &keep_last(size_t depth)
+    {
+      history_ = HistoryPolicy::KEEP_LAST;
+      depth_ = depth;
+      return *this;
+    }
+
+    QoS &keep_all()
+    {
+      history_ = HistoryPolicy::KEEP_ALL;
+      return *this;
+    }
+
+    QoS &reliability(ReliabilityPolicy reliability)
+    {
+      reliability_ = reliability;
+      return *this;
+    }
+
+    QoS &reliable()
+    {
+      return reliability(ReliabilityPolicy::RELIABLE);
+    }
+
+    QoS &best_effort()
+    {
+      return reliability(ReliabilityPolicy::BEST_EFFORT);
+    }
+
+    QoS &durability(DurabilityPolicy durability)
+    {
+      durability_ = durability;
+      return *this;
+    }
+
+    QoS &durability_volatile()
+    {
+      return durability(DurabilityPolicy::VOLATILE);
+    }
+
+    QoS &transient_local()
+    {
+      return durability(DurabilityPolicy::TRANSIENT_LOCAL);
+    }
+
+    ReliabilityPolicy get_reliability() const
+    {
+      return reliability_;
+    }
+
+    DurabilityPolicy get_durability() const
+    {
+      return durability_;
+    }
+
+    HistoryPolicy get_history() const
+    {
+      return history_;
+    }
+
+    size_t get_depth() const
+    {
+      return depth_;
+    }
+
+    // Sets reliability, history and, unless SYSTEM_DEFAULT, durability of a Fast DDS writer or
+    // reader QoS.
+    void apply(dds::DataWriterQos &qos) const;
+    void apply(dds::DataReaderQos &qos) const;
+
+  private:
+    ReliabilityPolicy reliability_{ReliabilityPolicy::RELIABLE};
+    DurabilityPolicy durability_{DurabilityPolicy::SYSTEM_DEFAULT};
+    HistoryPolicy history_{HistoryPolicy::KEEP_LAST};
+    size_t depth_;
+  };
+
+  // Camera, lidar and other streams where only the newest sample matters: best effort,
+  // volatile, depth 1.
+  class SensorDataQoS : public QoS
+  {
+  public:
+    SensorDataQoS() : QoS(1)
+    {
+      best_effort().durability_volatile();
+    }
+  };
+
+  // Reliable, depth 10, default durability (same as QoS()).
+  class ReliableQoS : public QoS
+  {
+  public:
+    ReliableQoS() : QoS(10) {}
+  };
+
+  // Latched data such as maps or tf_static: reliable, transient local, depth 1.
+  class TransientLocalQoS : public QoS
+  {
+  public:
+    TransientLocalQoS() : QoS(1)
+    {
+      transient_local();
+    }
+  };
+
+  // The /clock topic as ROS 2 publishes it: best effort, volatile, depth 1.
+  class ClockQoS : public QoS
+  {
+  public:
+    ClockQoS() : QoS(1)
+    {
+      best_effort().durability_volatile();
+    }
+  };
+
+  // Maps "default", "reliable", "sensor_data", "transient_local" and "clock" (as used in YAML
+  // configs) to a preset.
+  bool parse_qos_profile(const std::string &name, QoS &qos);
+
+} // namespace lwrcl
+
+#endif // LWRCL_QOS_HPP_
@@ -0,0 +1,146 @@
+#ifndef LWRCL_RING_BUFFER_HPP_
+#define LWRCL_RING_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace lwrcl
+{
+
+  // Bounded lock-free ring buffer (Vyukov sequence-cell queue).
+  // Any number of threads may push; pop is also safe from several threads, which lets a
+  // producer evict the oldest element when the ring is full.
+  template <class T>
+  class LockFreeRingBuffer
+  {
+  public:
+    explicit LockFreeRingBuffer(size_t capacity)
+        : capacity_(round_up_pow2(capacity)), mask_(capacity_ - 1), cells_(new Cell[capacity_])
+    {
+      for (size_t i = 0; i < capacity_; ++i)
+      {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+      }
+      enqueue_pos_.store(0, std::memory_order_relaxed);
+      dequeue_pos_.store(0, std::memory_order_relaxed);
+    }
+
+    LockFreeRingBuffer(const LockFreeRingBuffer &) = delete;
+    LockFreeRingBuffer &operator=(const LockFreeRingBuffer &) = delete;
+
+    // Moves x into the ring. Returns false (x untouched) when the ring is full.
+    bool push(T &x)
+    {
+      Cell *cell;
+      size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        cell = &cells_[pos & mask_];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0)
+        {
+          if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            break;
+          }
+        }
+        else if (diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+      }
+      cell->data = std::move(x);
+      cell->sequence.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Moves the oldest element into x. Returns false when the ring is empty.
+    bool pop(T &x)
+    {
+      Cell *cell;
+      size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        cell = &cells_[pos & mask_];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0)
+        {
+          if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            break;
+          }
+        }
+        else if (diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+      }
+      x = std::move(cell->data);
+      cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Approximate when called concurrently with push/pop.
+    bool empty() const
+    {
+      return size() == 0;
+    }
+
+    size_t size() const
+    {
+      size_t head = dequeue_pos_.load(std::memory_order_acquire);
+      size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+      return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const
+    {
+      return capacity_;
+    }
+
+  private:
+    struct Cell
+    {
+      std::atomic<size_t> sequence;
+      T data;
+    };
+
+    static size_t round_up_pow2(size_t value)
+    {
+      if (value < 2)
+      {
+        throw std::invalid_argument("Ring buffer capacity must be at least 2");
+      }
+      size_t result = 1;
+      while (result < value)
+      {
+        result <<= 1;
+      }
+      return result;
+    }
+
+    static constexpr size_t kCacheLineSize = 64;
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_pos_;
+    alignas(kCacheLineSize) std::atomic<size_t> dequeue_pos_;
+  };
+
+} // namespace lwrcl
+
+#endif // LWRCL_RING_BUFFER_HPP_
@@ -3,31 +3,291 @@
 
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "fast_dds_header.hpp"
 #include "channel.hpp"
+#include "qos.hpp"
+#include "wait_set.hpp"
+#include "intra_process.hpp"
 
 namespace lwrcl
 {
+  // Filter evaluated by DDS before samples reach the subscription (see ContentFilteredTopic).
+  struct ContentFilterOptions
+  {
+    // DDS-SQL WHERE clause over the message fields, e.g. "robot_id = %0" or
+    // "header.frame_id = 'base_link'"; empty disables filtering.
+    std::string filter_expression;
+    // Values of %0, %1, ... in filter_expression; strings are quoted, e.g. "'map'".
+    std::vector<std::string> expression_parameters;
+  };
+
+  // Per-subscription options, passed to Node::create_subscription.
+  struct SubscriptionOptions
+  {
+    // Take samples as DataReader loans and run the callback on the loaned sample in place; the
+    // loan is returned when the callback finishes. Over data sharing a plain (fixed-size) type
+    // is never copied; other types are deserialized once instead of copied twice. Every queued
+    // callback holds a loan, so the QoS history depth bounds how many can be pending.
+    bool loaned_samples = false;
+    // Each notification takes every available sample, in batches of at most this many, and
+    // queues a batch with a single channel operation.
+    int32_t max_samples_per_take = 32;
+    // Message instances kept for reuse in copy mode, preallocated with the subscription. More
+    // samples than this can be buffered, but the extra instances are freed after their callback.
+    size_t message_pool_size = 16;
+    // Leave reception to the executor: the reader gets no data listener, the executor thread
+    // blocks on a DDS WaitSet with the reader's read condition, and the samples are taken on
+    // that thread right before the callback runs, at most max_samples_per_take per entry.
+    // Nothing is buffered between reception and callback, so no listener-thread handoff or
+    // message pool is involved. Served by executors and Node::spin; a plain spin_some() loop
+    // polls the read condition instead.
+    bool wait_set = false;
+    // Only samples passing the filter are delivered. Writers that support it filter before
+    // sending, so rejected samples never cross the wire or get deserialized.
+    ContentFilterOptions content_filter_options;
+  };
+
+  // Sample loaned from a DataReader; the loan is returned when this is destroyed.
+  template <typename T>
+  struct LoanedSample
+  {
+    ~LoanedSample()
+    {
+      if (reader != nullptr && reader->return_loan(data, infos) != ReturnCode_t::RETCODE_OK)
+      {
+        std::cerr << "Error: Failed to return a loaned sample" << std::endl;
+      }
+    }
+
+    dds::DataReader *reader{nullptr}; // Set once the take succeeded.
+    dds::LoanableSequence<T> data;
+    dds::SampleInfoSeq infos;
+  };
+
+  // A received sample waiting for its callback, held by a pooled instance, a loan or an
+  // intra-process publisher's message.
+  template <typename T>
+  struct BufferedMessage
+  {
+    T *message{nullptr};
+    std::unique_ptr<T> instance;           // Copy mode, returned to the MessagePool after use.
+    std::shared_ptr<LoanedSample<T>> loan; // Loaned mode, shared by the samples of one take.
+    std::shared_ptr<const T> shared;       // Intra-process, shared with the other subscriptions.
+    uint64_t sequence{0};                  // Assigned by SubscriptionCallback::push().
+  };
+
+  // Reusable message instances of one subscription. A reused instance keeps the capacity of
+  // large members such as Image::data(), so a warm pool receives without allocating. Not
+  // thread-safe; SubscriptionCallback guards it.
+  template <typename T>
+  class MessagePool
+  {
+  public:
+    explicit MessagePool(size_t capacity) : capacity_(capacity)
+    {
+      free_.reserve(capacity_);
+      for (size_t i = 0; i < capacity_; ++i)
+      {
+        free_.push_back(std::make_unique<T>());
+      }
+    }
+
+    // Falls back to a fresh instance while every pooled one is in use.
+    std::unique_ptr<T> acquire()
+    {
+      if (free_.empty())
+      {
+        return std::make_unique<T>();
+      }
+      std::unique_ptr<T> instance = std::move(free_.back());
+      free_.pop_back();
+      return instance;
+    }
+
+    // Instances beyond the pool capacity are freed, bounding the memory kept per subscription.
+    void release(std::unique_ptr<T> instance)
+    {
+      if (instance && free_.size() < capacity_)
+      {
+        free_.push_back(std::move(instance));
+      }
+    }
+
+  private:
+    size_t capacity_;
+    std::vector<std::unique_ptr<T>> free_;
+  };
+
+  namespace detail
+  {
+    template <typename F, typename Arg, typename = void>
+    struct is_callable_with : std::false_type
+    {
+    };
+
+    template <typename F, typename Arg>
+    struct is_callable_with<F, Arg, decltype(void(std::declval<F &>()(std::declval<Arg>())))> : std::true_type
+    {
+    };
+  } // namespace detail
+
+  // Subscription callback taking T *, std::unique_ptr<T> or std::shared_ptr<const T>, like
+  // rclcpp::AnySubscriptionCallback. A T * callback borrows the message for the duration of the
+  // call. The other two take ownership: the received instance is handed over without a copy,
+  // so it can be moved into another pipeline stage or shared across consumers. Their
+  // subscriptions keep no message pool; each sample is taken into a freshly allocated
+  // instance, and loaned samples are copied.
+  template <typename T>
+  class AnySubscriptionCallback
+  {
+  public:
+    template <typename F,
+              typename std::enable_if<detail::is_callable_with<F, T *>::value, int>::type = 0>
+    AnySubscriptionCallback(F callback) : borrowed_(callback) {}
+
+    // A shared_ptr<const T> callback is also callable with a unique_ptr<T>, so it is matched first.
+    template <typename F,
+              typename std::enable_if<!detail::is_callable_with<F, T *>::value &&
+                                          detail::is_callable_with<F, std::shared_ptr<const T>>::value,
+                                      int>::type = 0>
+    AnySubscriptionCallback(F callback) : shared_(callback) {}
+
+    template <typename F,
+              typename std::enable_if<!detail::is_callable_with<F, T *>::value &&
+                                          !detail::is_callable_with<F, std::shared_ptr<const T>>::value &&
+                                          detail::is_callable_with<F, std::unique_ptr<T>>::value,
+                                      int>::type = 0>
+    AnySubscriptionCallback(F callback) : unique_(callback) {}
+
+    bool takes_ownership() const
+    {
+      return !borrowed_;
+    }
+
+    // instance owns *message, or is empty when message is borrowed (e.g. a loan). Ownership
+    // callbacks move it out. A message shared with other intra-process subscriptions is passed
+    // on as is to shared_ptr callbacks and copied for unique_ptr ones.
+    void dispatch(T *message, std::unique_ptr<T> &instance, const std::shared_ptr<const T> &shared = nullptr)
+    {
+      if (borrowed_)
+      {
+        borrowed_(message);
+        return;
+      }
+      if (shared_ && shared)
+      {
+        shared_(shared);
+        return;
+      }
+      std::unique_ptr<T> owned = instance ? std::move(instance) : std::make_unique<T>(*message);
+      if (shared_)
+      {
+        shared_(std::shared_ptr<const T>(std::move(owned)));
+      }
+      else
+      {
+        unique_(std::move(owned));
+      }
+    }
+
+  private:
+    std::function<void(T *)> borrowed_;
+    std::function<void(std::unique_ptr<T>)> unique_;
+    std::function<void(std::shared_ptr<const T>)> shared_;
+  };
+
   template <typename T>
   class SubscriptionCallback : public ChannelCallback
   {
   public:
-    SubscriptionCallback(std::function<void(T *)> callback_function, std::vector<std::shared_ptr<T>> *message_buffer)
-        : callback_function_(callback_function), message_buffer_(message_buffer) {}
+    SubscriptionCallback(AnySubscriptionCallback<T> callback_function, size_t pool_size = 0)
+        : callback_function_(callback_function), pool_(pool_size), buffer_(pool_size > 0 ? pool_size : 1) {}
 
     ~SubscriptionCallback() = default;
 
-    void invoke()
+    // Instance to take the next sample into; hand it back with push() or release().
+    std::unique_ptr<T> acquire()
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      return pool_.acquire();
+    }
+
+    void release(std::unique_ptr<T> instance)
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      pool_.release(std::move(instance));
+    }
+
+    // Buffers received samples; one channel entry is produced per pushed sample. Returns the
+    // sequence number of the first one, consecutive for the rest, to pass to remove().
+    uint64_t push(std::vector<BufferedMessage<T>> &messages)
     {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      uint64_t first = next_sequence_;
+      for (auto &message : messages)
+      {
+        push_locked(message);
+      }
+      return first;
+    }
+
+    uint64_t push(BufferedMessage<T> &message)
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      uint64_t sequence = next_sequence_;
+      push_locked(message);
+      return sequence;
+    }
+
+    // Drops the count samples pushed from sequence first on, when the channel rejected their
+    // entries. Other threads (intra-process publishers, the DDS listener) may have pushed
+    // since. If an executed entry of theirs already took one of these samples, one of their
+    // samples is dropped in its place, so every buffered sample keeps a queued entry.
+    void remove(uint64_t first, size_t count)
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      for (uint64_t sequence = first + count; sequence-- > first && buffered_ > 0;)
+      {
+        remove_locked(sequence);
+      }
+    }
+
+    void discard()
+    {
+      BufferedMessage<T> message;
+      take_oldest(message);
+      recycle(message);
+    }
+
+    // Drops every buffered sample, returning loans before the reader is deleted.
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      for (; buffered_ > 0; --buffered_)
+      {
+        recycle_locked(buffer_[head_]);
+        head_ = (head_ + 1) % buffer_.size();
+      }
+    }
+
+  protected:
+    void execute() override
+    {
+      BufferedMessage<T> message;
       try
       {
-        if (!message_buffer_->empty())
+        if (take_oldest(message))
         {
-          callback_function_(message_buffer_->front().get());
-          message_buffer_->erase(message_buffer_->begin());
+          callback_function_.dispatch(message.message, message.instance, message.shared);
         }
         else
         {
@@ -42,11 +302,251 @@ namespace lwrcl
       {
         std::cerr << "Unknown exception during callback invocation." << std::endl;
       }
+      recycle(message);
     }
 
   private:
-    std::function<void(T *)> callback_function_;
-    std::vector<std::shared_ptr<T>> *message_buffer_;
+    void push_locked(BufferedMessage<T> &message)
+    {
+      if (buffered_ == buffer_.size())
+      {
+        grow_locked();
+      }
+      message.sequence = next_sequence_++;
+      buffer_[(head_ + buffered_) % buffer_.size()] = std::move(message);
+      ++buffered_;
+    }
+
+    // Removes the sample pushed as sequence, or the newest one when it was already taken.
+    void remove_locked(uint64_t sequence)
+    {
+      size_t i = buffered_ - 1;
+      while (i > 0 && buffer_[(head_ + i) % buffer_.size()].sequence != sequence)
+      {
+        --i;
+      }
+      if (buffer_[(head_ + i) % buffer_.size()].sequence != sequence)
+      {
+        i = buffered_ - 1;
+      }
+      recycle_locked(buffer_[(head_ + i) % buffer_.size()]);
+      for (; i + 1 < buffered_; ++i)
+      {
+        buffer_[(head_ + i) % buffer_.size()] = std::move(buffer_[(head_ + i + 1) % buffer_.size()]);
+      }
+      --buffered_;
+    }
+
+    bool take_oldest(BufferedMessage<T> &message)
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      if (buffered_ == 0)
+      {
+        return false;
+      }
+      message = std::move(buffer_[head_]);
+      head_ = (head_ + 1) % buffer_.size();
+      --buffered_;
+      return true;
+    }
+
+    void recycle(BufferedMessage<T> &message)
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      recycle_locked(message);
+    }
+
+    void recycle_locked(BufferedMessage<T> &message)
+    {
+      pool_.release(std::move(message.instance));
+      message.loan.reset(); // Returns the loan once the last sample of its take is done.
+      message.shared.reset();
+      message.message = nullptr;
+    }
+
+    // Only when more samples are buffered than ever before.
+    void grow_locked()
+    {
+      std::vector<BufferedMessage<T>> grown(buffer_.size() * 2);
+      for (size_t i = 0; i < buffered_; ++i)
+      {
+        grown[i] = std::move(buffer_[(head_ + i) % buffer_.size()]);
+      }
+      buffer_.swap(grown);
+      head_ = 0;
+    }
+
+    AnySubscriptionCallback<T> callback_function_;
+    MessagePool<T> pool_;
+    std::vector<BufferedMessage<T>> buffer_; // Ring of buffered_ samples starting at head_.
+    size_t head_{0};
+    size_t buffered_{0};
+    uint64_t next_sequence_{0};
+    std::mutex buffer_mutex_;
+  };
+
+  // Channel entry of a wait-set subscription. At most one is pending; executing it takes the
+  // available samples on the executor thread and runs the callback on each of them.
+  template <typename T>
+  class ReaderCallback : public ChannelCallback
+  {
+  public:
+    ReaderCallback(AnySubscriptionCallback<T> callback_function, Channel<ChannelCallback *> &channel,
+                   const SubscriptionOptions &options, dds::DataReader *reader, dds::ReadCondition *condition)
+        : callback_function_(callback_function), channel_(channel), options_(options), reader_(reader),
+          condition_(condition)
+    {
+    }
+
+    ~ReaderCallback()
+    {
+      bind(nullptr);
+    }
+
+    // Queues the entry unless one is pending. Returns false when the channel had no room, so
+    // the caller retries later.
+    bool trigger()
+    {
+      if (!armed_.exchange(false))
+      {
+        return true;
+      }
+      if (channel_.try_produce(this))
+      {
+        return true;
+      }
+      armed_.store(true);
+      return channel_.is_closed();
+    }
+
+    void poll()
+    {
+      if (condition_->get_trigger_value())
+      {
+        trigger();
+      }
+    }
+
+    // Moves the read condition to waiter's WaitSet; nullptr only detaches it.
+    void bind(WaitSetWaiter *waiter)
+    {
+      std::lock_guard<std::mutex> lock(waiter_mutex_);
+      if (waiter_ == waiter)
+      {
+        return;
+      }
+      if (waiter_)
+      {
+        waiter_->detach(condition_);
+      }
+      waiter_ = waiter;
+      if (waiter_)
+      {
+        waiter_->attach(condition_, [this]
+                        { return trigger(); });
+      }
+    }
+
+    void discard() override
+    {
+      rearm();
+    }
+
+  protected:
+    void execute() override
+    {
+      if (options_.loaned_samples)
+      {
+        take_loaned();
+      }
+      else
+      {
+        take_copies();
+      }
+      rearm();
+    }
+
+  private:
+    void take_loaned()
+    {
+      dds::LoanableSequence<T> data;
+      dds::SampleInfoSeq infos;
+      if (reader_->take(data, infos, options_.max_samples_per_take) != ReturnCode_t::RETCODE_OK)
+      {
+        return;
+      }
+      for (int32_t i = 0; i < infos.length(); ++i)
+      {
+        if (infos[i].valid_data)
+        {
+          std::unique_ptr<T> borrowed;
+          call(&data[i], borrowed);
+        }
+      }
+      if (reader_->return_loan(data, infos) != ReturnCode_t::RETCODE_OK)
+      {
+        std::cerr << "Error: Failed to return a loaned sample" << std::endl;
+      }
+    }
+
+    // Every sample is deserialized into the same instance, unless the callback took it.
+    void take_copies()
+    {
+      for (int32_t taken = 0; taken < options_.max_samples_per_take; ++taken)
+      {
+        if (!instance_)
+        {
+          instance_ = std::make_unique<T>();
+        }
+        if (reader_->take_next_sample(instance_.get(), &sample_info_) != ReturnCode_t::RETCODE_OK)
+        {
+          return;
+        }
+        if (sample_info_.valid_data)
+        {
+          call(instance_.get(), instance_);
+        }
+      }
+    }
+
+    void call(T *message, std::unique_ptr<T> &instance)
+    {
+      try
+      {
+        callback_function_.dispatch(message, instance);
+      }
+      catch (const std::exception &e)
+      {
+        std::cerr << "Exception during callback invocation: " << e.what() << std::endl;
+      }
+      catch (...)
+      {
+        std::cerr << "Unknown exception during callback invocation." << std::endl;
+      }
+    }
+
+    // Samples that arrived meanwhile, or did not fit in this take, keep the condition
+    // triggered, so the waiter queues the next entry right away.
+    void rearm()
+    {
+      armed_.store(true);
+      std::lock_guard<std::mutex> lock(waiter_mutex_);
+      if (waiter_)
+      {
+        waiter_->rearm(condition_);
+      }
+    }
+
+    AnySubscriptionCallback<T> callback_function_;
+    Channel<ChannelCallback *> &channel_;
+    SubscriptionOptions options_;
+    dds::DataReader *reader_;
+    dds::ReadCondition *condition_;
+    std::atomic<bool> armed_{true}; // No entry is pending.
+    std::mutex waiter_mutex_;
+    WaitSetWaiter *waiter_{nullptr};
+    std::unique_ptr<T> instance_;
+    dds::SampleInfo sample_info_;
   };
 
   template <typename T>
@@ -62,31 +562,159 @@ namespace lwrcl
       count = status.current_count;
     }
 
+    // One notification may stand for several samples, so all of them are taken; samples left
+    // in the history could be overwritten before the next notification.
     void on_data_available(dds::DataReader *reader) override
     {
-      T temp_instance;
-      if (reader->take_next_sample(&temp_instance, &sample_info_) == ReturnCode_t::RETCODE_OK && sample_info_.valid_data)
+      bool more = true;
+      while (more)
       {
-        auto data_ptr = std::make_shared<T>(temp_instance);
-        message_ptr_buffer_.emplace_back(data_ptr);
-        channel_.produce(subscription_callback_.get());
+        more = options_.loaned_samples ? take_loaned(reader) : take_copies(reader);
+        if (!messages_.empty())
+        {
+          enqueue_messages();
+        }
       }
     }
 
-    SubscriberListener(MessageType *message_type, std::function<void(T *)> callback_function, Channel<ChannelCallback *> &channel)
-        : message_type_(message_type), callback_function_(callback_function), channel_(channel)
+    SubscriberListener(MessageType *message_type, AnySubscriptionCallback<T> callback_function, Channel<ChannelCallback *> &channel,
+                       const SubscriptionOptions &options = SubscriptionOptions())
+        : message_type_(message_type), callback_function_(callback_function), channel_(channel), options_(options)
     {
-      subscription_callback_ = std::make_unique<SubscriptionCallback<T>>(callback_function_, &message_ptr_buffer_);
+      subscription_callback_ = std::make_unique<SubscriptionCallback<T>>(callback_function_, pool_size());
     }
     std::atomic<int32_t> count{0};
 
+    ChannelCallback *get_callback()
+    {
+      return subscription_callback_.get();
+    }
+
+    void clear_buffered_samples()
+    {
+      subscription_callback_->clear();
+    }
+
+    // Samples of this topic's intra-process writers are dropped from now on; the subscription
+    // receives them through deliver_intra_process().
+    void set_intra_process_topic(std::shared_ptr<IntraProcessTopic> topic)
+    {
+      intra_process_topic_ = topic;
+    }
+
+    // Never blocks: with OverflowPolicy::BLOCK a full channel drops the message, because the
+    // publishing thread may be the one that has to drain it. A T * callback may modify its
+    // message, so it gets a private copy unless the message is exclusive to this subscription.
+    void deliver_intra_process(const std::shared_ptr<T> &message, bool exclusive)
+    {
+      BufferedMessage<T> buffered;
+      if (exclusive || callback_function_.takes_ownership())
+      {
+        buffered.message = message.get();
+        buffered.shared = message;
+      }
+      else
+      {
+        std::unique_ptr<T> instance = subscription_callback_->acquire();
+        *instance = *message;
+        buffered.message = instance.get();
+        buffered.instance = std::move(instance);
+      }
+      uint64_t sequence = subscription_callback_->push(buffered);
+      if (!channel_.try_produce(subscription_callback_.get()))
+      {
+        subscription_callback_->remove(sequence, 1);
+      }
+    }
+
   private:
+    // Loans, wait-set subscriptions and ownership-taking callbacks would leave a pool unused.
+    size_t pool_size() const
+    {
+      if (options_.loaned_samples || options_.wait_set || callback_function_.takes_ownership())
+      {
+        return 0;
+      }
+      return options_.message_pool_size;
+    }
+
+    // Each take fills messages_ with at most max_samples_per_take samples; returns true when the
+    // batch was full, so more samples may be available.
+    bool take_loaned(dds::DataReader *reader)
+    {
+      auto loan = std::make_shared<LoanedSample<T>>();
+      if (reader->take(loan->data, loan->infos, options_.max_samples_per_take) != ReturnCode_t::RETCODE_OK)
+      {
+        return false;
+      }
+      loan->reader = reader;
+      int32_t length = loan->infos.length();
+      for (int32_t i = 0; i < length; ++i)
+      {
+        if (loan->infos[i].valid_data && !from_intra_process_writer(loan->infos[i]))
+        {
+          // Shares ownership of the loan, returned once every sample of the batch is released.
+          messages_.emplace_back();
+          messages_.back().message = &loan->data[i];
+          messages_.back().loan = loan;
+        }
+      }
+      return length >= options_.max_samples_per_take;
+    }
+
+    bool take_copies(dds::DataReader *reader)
+    {
+      for (int32_t taken = 0; taken < options_.max_samples_per_take; ++taken)
+      {
+        // Deserialized straight into a pooled instance.
+        std::unique_ptr<T> instance = subscription_callback_->acquire();
+        if (reader->take_next_sample(instance.get(), &sample_info_) != ReturnCode_t::RETCODE_OK)
+        {
+          subscription_callback_->release(std::move(instance));
+          return false;
+        }
+        if (!sample_info_.valid_data || from_intra_process_writer(sample_info_))
+        {
+          subscription_callback_->release(std::move(instance));
+          continue;
+        }
+        messages_.emplace_back();
+        messages_.back().message = instance.get();
+        messages_.back().instance = std::move(instance);
+      }
+      return true;
+    }
+
+    // Already delivered within the process.
+    bool from_intra_process_writer(const dds::SampleInfo &info)
+    {
+      return intra_process_topic_ && intra_process_topic_->is_local_writer(info.publication_handle);
+    }
+
+    void enqueue_messages()
+    {
+      size_t count = messages_.size();
+      uint64_t first = subscription_callback_->push(messages_);
+      messages_.clear();
+      entries_.assign(count, subscription_callback_.get());
+      size_t produced = channel_.produce_batch(entries_);
+      if (produced < count)
+      {
+        // The batch is rejected from its first unqueued entry on.
+        subscription_callback_->remove(first + produced, count - produced);
+      }
+    }
+
     MessageType *message_type_;
-    std::function<void(T *)> callback_function_;
+    AnySubscriptionCallback<T> callback_function_;
     Channel<ChannelCallback *> &channel_;
-    std::vector<std::shared_ptr<T>> message_ptr_buffer_;
+    SubscriptionOptions options_;
+    // Reused by the listener thread; Fast DDS does not call on_data_available concurrently for one reader.
+    std::vector<BufferedMessage<T>> messages_;
+    std::vector<ChannelCallback *> entries_;
     std::unique_ptr<SubscriptionCallback<T>> subscription_callback_;
     dds::SampleInfo sample_info_;
+    std::shared_ptr<IntraProcessTopic> intra_process_topic_;
   };
 
   class ISubscriber
@@ -94,18 +722,34 @@ namespace lwrcl
   public:
     virtual ~ISubscriber() = default;
     virtual int32_t get_publisher_count() = 0;
+    // Wait-set subscriptions wait on the WaitSetWaiter of notifier; nullptr detaches.
+    virtual void set_event_notifier(EventNotifier *)
+    {
+    }
+    // Queues a wait-set subscription's entry if its read condition has triggered.
+    virtual void poll()
+    {
+    }
   };
 
   template <typename T>
-  class Subscriber : public ISubscriber
+  class Subscriber : public ISubscriber, public IntraProcessSubscription<T>
   {
   public:
+    // With intra_process, messages of intra-process publishers of the same participant arrive
+    // directly instead of through DDS (see IntraProcessTopic). Wait-set and content-filtered
+    // subscriptions always receive through DDS.
     Subscriber(dds::DomainParticipant *participant, MessageType *message_type, const std::string &topic,
-               const dds::TopicQos &qos, std::function<void(T *)> callback_function,
-               Channel<ChannelCallback *> &channel)
+               const dds::TopicQos &qos, AnySubscriptionCallback<T> callback_function,
+               Channel<ChannelCallback *> &channel, const SubscriptionOptions &options = SubscriptionOptions(),
+               const QoS &endpoint_qos = QoS(), bool intra_process = false)
         : participant_(participant),
-          listener_(message_type, callback_function, channel)
+          listener_(message_type, callback_function, channel, options)
     {
+      if (options.max_samples_per_take <= 0)
+      {
+        throw std::invalid_argument("max_samples_per_take must be positive");
+      }
       if (message_type->get_type_support().register_type(participant_) != ReturnCode_t::RETCODE_OK)
       {
         throw std::runtime_error("Failed to register message type");
@@ -125,41 +769,89 @@ namespace lwrcl
         topic_ = retrieved_topic;
       }
 
+      dds::TopicDescription *reader_topic = topic_;
+      const ContentFilterOptions &filter = options.content_filter_options;
+      if (!filter.filter_expression.empty())
+      {
+        filtered_topic_ = participant_->create_contentfilteredtopic(
+            filtered_topic_name(topic), topic_, filter.filter_expression, filter.expression_parameters);
+        if (!filtered_topic_)
+        {
+          participant_->delete_topic(topic_);
+          throw std::invalid_argument("Failed to create content filtered topic for: " + filter.filter_expression);
+        }
+        reader_topic = filtered_topic_;
+      }
+
       subscriber_ = participant_->create_subscriber(dds::SUBSCRIBER_QOS_DEFAULT);
       if (!subscriber_)
       {
-        participant_->delete_topic(topic_);
+        delete_topics();
         throw std::runtime_error("Failed to create subscriber");
       }
       dds::DataReaderQos reader_qos = dds::DATAREADER_QOS_DEFAULT;
       reader_qos.endpoint().history_memory_policy = rtps::PREALLOCATED_WITH_REALLOC_MEMORY_MODE;
-      reader_qos.history().depth = 10;
-      reader_qos.reliability().kind = dds::RELIABLE_RELIABILITY_QOS;
-      // reader_qos.durability().kind = dds::TRANSIENT_LOCAL_DURABILITY_QOS;
+      endpoint_qos.apply(reader_qos);
       reader_qos.data_sharing().automatic();
-      reader_ = subscriber_->create_datareader(topic_, reader_qos, &listener_);
+      if (intra_process && !options.wait_set && filter.filter_expression.empty())
+      {
+        // Set before the reader exists so no DDS copy of a local sample slips through.
+        intra_process_topic_ = IntraProcessTopic::get(participant_, topic);
+        listener_.set_intra_process_topic(intra_process_topic_);
+      }
+      // In wait-set mode the listener only tracks matched publishers.
+      reader_ = subscriber_->create_datareader(
+          reader_topic, reader_qos, &listener_,
+          options.wait_set ? dds::StatusMask::subscription_matched() : dds::StatusMask::all());
       if (!reader_)
       {
         participant_->delete_subscriber(subscriber_);
-        participant_->delete_topic(topic_);
+        delete_topics();
         throw std::runtime_error("Failed to create datareader");
       }
+      if (options.wait_set)
+      {
+        read_condition_ = reader_->create_readcondition(dds::NOT_READ_SAMPLE_STATE, dds::ANY_VIEW_STATE,
+                                                        dds::ANY_INSTANCE_STATE);
+        if (!read_condition_)
+        {
+          subscriber_->delete_datareader(reader_);
+          participant_->delete_subscriber(subscriber_);
+          delete_topics();
+          throw std::runtime_error("Failed to create read condition");
+        }
+        reader_callback_ = std::make_unique<ReaderCallback<T>>(callback_function, channel, options, reader_,
+                                                               read_condition_);
+      }
+      if (intra_process_topic_)
+      {
+        intra_process_topic_->add_subscription(this);
+      }
     }
 
     ~Subscriber()
     {
+      if (intra_process_topic_)
+      {
+        intra_process_topic_->remove_subscription(this);
+      }
       if (reader_ != nullptr)
       {
+        // Loans must be back before the reader can be deleted.
+        reader_->set_listener(nullptr);
+        listener_.clear_buffered_samples();
+        if (read_condition_ != nullptr)
+        {
+          reader_callback_.reset(); // Detaches the condition from the executor's WaitSet.
+          reader_->delete_readcondition(read_condition_);
+        }
         subscriber_->delete_datareader(reader_);
       }
       if (subscriber_ != nullptr)
       {
         participant_->delete_subscriber(subscriber_);
       }
-      if (topic_ != nullptr)
-      {
-        participant_->delete_topic(topic_);
-      }
+      delete_topics();
     }
 
     int32_t get_publisher_count()
@@ -167,12 +859,90 @@ namespace lwrcl
       return listener_.count.load();
     }
 
+    void set_event_notifier(EventNotifier *notifier) override
+    {
+      if (reader_callback_)
+      {
+        reader_callback_->bind(notifier ? get_wait_set_waiter(*notifier) : nullptr);
+      }
+    }
+
+    void poll() override
+    {
+      if (reader_callback_)
+      {
+        reader_callback_->poll();
+      }
+    }
+
+    dds::InstanceHandle_t get_reader_handle() const override
+    {
+      return reader_->get_instance_handle();
+    }
+
+    void deliver(const std::shared_ptr<T> &message, bool exclusive) override
+    {
+      listener_.deliver_intra_process(message, exclusive);
+    }
+
+    // Dispatch priority of this subscription's callback (see ChannelOptions::priority_dispatch).
+    void set_priority(int priority)
+    {
+      get_channel_callback()->set_priority(priority);
+    }
+
+    int get_priority()
+    {
+      return get_channel_callback()->get_priority();
+    }
+
+    // Replaces the parameters of the content filter; false without a filter or when DDS
+    // rejects them.
+    bool set_content_filter_parameters(const std::vector<std::string> &expression_parameters)
+    {
+      return filtered_topic_ != nullptr &&
+             filtered_topic_->set_expression_parameters(expression_parameters) == ReturnCode_t::RETCODE_OK;
+    }
+
+    ChannelCallback *get_channel_callback()
+    {
+      if (reader_callback_)
+      {
+        return reader_callback_.get();
+      }
+      return listener_.get_callback();
+    }
+
   private:
+    // Content filtered topics share the participant's namespace with topics, so each needs a
+    // name of its own.
+    static std::string filtered_topic_name(const std::string &topic)
+    {
+      static std::atomic<uint32_t> counter{0};
+      return topic + "/filtered_" + std::to_string(counter.fetch_add(1));
+    }
+
+    void delete_topics()
+    {
+      if (filtered_topic_ != nullptr)
+      {
+        participant_->delete_contentfilteredtopic(filtered_topic_);
+      }
+      if (topic_ != nullptr)
+      {
+        participant_->delete_topic(topic_);
+      }
+    }
+
     dds::DomainParticipant *participant_;
     SubscriberListener<T> listener_;
     dds::Topic *topic_;
+    dds::ContentFilteredTopic *filtered_topic_{nullptr};
     dds::Subscriber *subscriber_;
     dds::DataReader *reader_;
+    dds::ReadCondition *read_condition_{nullptr}; // Wait-set mode only.
+    std::unique_ptr<ReaderCallback<T>> reader_callback_;
+    std::shared_ptr<IntraProcessTopic> intra_process_topic_;
   };
 
 } // namespace lwrcl
@@ -0,0 +1,319 @@
+#ifndef LWRCL_SYNCHRONIZER_HPP_
+#define LWRCL_SYNCHRONIZER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace lwrcl
+{
+
+  // Stamp of a message in nanoseconds, read from header().stamp(). Specialize for message
+  // types that carry their stamp elsewhere.
+  template <typename T>
+  struct MessageStamp
+  {
+    static int64_t get(const T &message)
+    {
+      return static_cast<int64_t>(message.header().stamp().sec()) * 1000000000 + message.header().stamp().nanosec();
+    }
+  };
+
+  // Stamps of a StampedRing, oldest first. The matching policies only look at this part.
+  class StampQueue
+  {
+  public:
+    explicit StampQueue(size_t capacity) : stamps_(capacity) {}
+
+    size_t size() const
+    {
+      return size_;
+    }
+
+    bool empty() const
+    {
+      return size_ == 0;
+    }
+
+    int64_t stamp(size_t i) const
+    {
+      return stamps_[slot(i)];
+    }
+
+    // Index of the first entry stamped at or after stamp, size() if there is none.
+    size_t lower_bound(int64_t stamp) const
+    {
+      size_t i = 0;
+      while (i < size_ && stamps_[slot(i)] < stamp)
+      {
+        ++i;
+      }
+      return i;
+    }
+
+    // Drops the count oldest entries.
+    void pop_front(size_t count)
+    {
+      count = std::min(count, size_);
+      head_ = (head_ + count) % stamps_.size();
+      size_ -= count;
+    }
+
+  protected:
+    size_t slot(size_t i) const
+    {
+      return (head_ + i) % stamps_.size();
+    }
+
+    std::vector<int64_t> stamps_;
+    size_t head_{0};
+    size_t size_{0};
+  };
+
+  // Bounded buffer of message copies sorted by stamp. Slots are preallocated and copy-assigned,
+  // so members such as Image::data() keep their capacity and a warm ring does not allocate.
+  template <typename T>
+  class StampedRing : public StampQueue
+  {
+  public:
+    explicit StampedRing(size_t capacity) : StampQueue(capacity), slots_(capacity) {}
+
+    // Evicts the oldest entry when full. Out-of-order messages are sorted in.
+    void push(const T &message, int64_t stamp)
+    {
+      if (size_ == slots_.size())
+      {
+        pop_front(1);
+      }
+      size_t i = size_++;
+      slots_[slot(i)] = message;
+      stamps_[slot(i)] = stamp;
+      for (; i > 0 && stamps_[slot(i - 1)] > stamp; --i)
+      {
+        std::swap(slots_[slot(i - 1)], slots_[slot(i)]);
+        std::swap(stamps_[slot(i - 1)], stamps_[slot(i)]);
+      }
+    }
+
+    T &at(size_t i)
+    {
+      return slots_[slot(i)];
+    }
+
+  private:
+    std::vector<T> slots_;
+  };
+
+  // Buffers the messages of several topics and calls one callback with a matched set, in the
+  // spirit of message_filters::Synchronizer. Feed it from ordinary subscriptions:
+  //
+  //   ApproximateTimeSynchronizer<Image, PointCloud2> sync(10, fused_callback);
+  //   node.create_subscription<Image>(&image_type, "camera", qos, sync.input<0>());
+  //   node.create_subscription<PointCloud2>(&cloud_type, "lidar", qos, sync.input<1>());
+  //
+  // Each topic keeps at most queue_size copies. The callback runs on the thread that completed
+  // the set, under the synchronizer's lock, and its pointers are only valid during the call.
+  template <typename... Ms>
+  class Synchronizer
+  {
+  public:
+    static constexpr size_t kTopics = sizeof...(Ms);
+    using Callback = std::function<void(Ms *...)>;
+    template <size_t I>
+    using MessageTypeAt = typename std::tuple_element<I, std::tuple<Ms...>>::type;
+
+    Synchronizer(size_t queue_size, Callback callback)
+        : Synchronizer(queue_size, callback, std::index_sequence_for<Ms...>()) {}
+
+    virtual ~Synchronizer() = default;
+
+    Synchronizer(const Synchronizer &) = delete;
+    Synchronizer &operator=(const Synchronizer &) = delete;
+
+    // Copies message into the buffer of topic I and calls the callback if a set is complete.
+    template <size_t I>
+    void add(const MessageTypeAt<I> *message)
+    {
+      if (message == nullptr)
+      {
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      int64_t stamp = MessageStamp<MessageTypeAt<I>>::get(*message);
+      std::get<I>(rings_).push(*message, stamp);
+      match(I, stamp);
+    }
+
+    // Subscription callback feeding topic I.
+    template <size_t I>
+    std::function<void(MessageTypeAt<I> *)> input()
+    {
+      return [this](MessageTypeAt<I> *message)
+      { add<I>(message); };
+    }
+
+    // Matched sets passed to the callback.
+    uint64_t get_matched_count()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return matched_count_;
+    }
+
+  protected:
+    using Selection = std::array<size_t, kTopics>;
+
+    // Called under the lock after a message stamped stamp was added to topic.
+    virtual void match(size_t topic, int64_t stamp) = 0;
+
+    StampQueue &queue(size_t topic)
+    {
+      return *queues_[topic];
+    }
+
+    // Calls the callback with entry selection[i] of every topic i, then drops those entries
+    // and everything older.
+    void emit(const Selection &selection)
+    {
+      invoke(selection, std::index_sequence_for<Ms...>());
+      ++matched_count_;
+      for (size_t i = 0; i < kTopics; ++i)
+      {
+        queues_[i]->pop_front(selection[i] + 1);
+      }
+    }
+
+  private:
+    template <size_t... Is>
+    Synchronizer(size_t queue_size, Callback callback, std::index_sequence<Is...>)
+        : callback_(callback), rings_(StampedRing<Ms>(queue_size)...), queues_{{&std::get<Is>(rings_)...}}
+    {
+      static_assert(sizeof...(Ms) >= 2, "Synchronizer needs at least two topics");
+      if (queue_size == 0)
+      {
+        throw std::invalid_argument("Synchronizer queue_size must be positive");
+      }
+    }
+
+    template <size_t... Is>
+    void invoke(const Selection &selection, std::index_sequence<Is...>)
+    {
+      callback_(&std::get<Is>(rings_).at(selection[Is])...);
+    }
+
+    Callback callback_;
+    std::tuple<StampedRing<Ms>...> rings_;
+    std::array<StampQueue *, kTopics> queues_;
+    std::mutex mutex_;
+    uint64_t matched_count_{0};
+  };
+
+  // Calls the callback when every topic has a message with exactly the same stamp.
+  template <typename... Ms>
+  class ExactTimeSynchronizer : public Synchronizer<Ms...>
+  {
+  public:
+    using Synchronizer<Ms...>::Synchronizer;
+
+  protected:
+    using typename Synchronizer<Ms...>::Selection;
+
+    // Only the new stamp can have completed a set.
+    void match(size_t, int64_t stamp) override
+    {
+      Selection selection;
+      for (size_t i = 0; i < this->kTopics; ++i)
+      {
+        StampQueue &queue = this->queue(i);
+        selection[i] = queue.lower_bound(stamp);
+        if (selection[i] == queue.size() || queue.stamp(selection[i]) != stamp)
+        {
+          return;
+        }
+      }
+      this->emit(selection);
+    }
+  };
+
+  // Calls the callback with the messages closest to each other in time. The newest of the
+  // oldest buffered messages is the pivot; every topic contributes its message nearest to it,
+  // once the topic also has one at or after the pivot so no closer message can still arrive.
+  // With set_max_interval, sets spread wider than that are discarded oldest message first.
+  template <typename... Ms>
+  class ApproximateTimeSynchronizer : public Synchronizer<Ms...>
+  {
+  public:
+    using Synchronizer<Ms...>::Synchronizer;
+
+    void set_max_interval(std::chrono::nanoseconds max_interval)
+    {
+      max_interval_ = max_interval.count();
+    }
+
+  protected:
+    using typename Synchronizer<Ms...>::Selection;
+
+    void match(size_t, int64_t) override
+    {
+      for (;;)
+      {
+        int64_t pivot = 0;
+        for (size_t i = 0; i < this->kTopics; ++i)
+        {
+          if (this->queue(i).empty())
+          {
+            return;
+          }
+          pivot = i == 0 ? this->queue(i).stamp(0) : std::max(pivot, this->queue(i).stamp(0));
+        }
+
+        Selection selection;
+        int64_t earliest = std::numeric_limits<int64_t>::max();
+        int64_t latest = std::numeric_limits<int64_t>::min();
+        size_t oldest_topic = 0; // Topic of the earliest selected message, dropped on rejection.
+        for (size_t i = 0; i < this->kTopics; ++i)
+        {
+          StampQueue &queue = this->queue(i);
+          size_t after = queue.lower_bound(pivot);
+          if (after == queue.size())
+          {
+            return;
+          }
+          selection[i] = after;
+          if (after > 0 && pivot - queue.stamp(after - 1) <= queue.stamp(after) - pivot)
+          {
+            selection[i] = after - 1;
+          }
+          int64_t stamp = queue.stamp(selection[i]);
+          if (stamp < earliest)
+          {
+            earliest = stamp;
+            oldest_topic = i;
+          }
+          latest = std::max(latest, stamp);
+        }
+
+        if (max_interval_ >= 0 && latest - earliest > max_interval_)
+        {
+          this->queue(oldest_topic).pop_front(selection[oldest_topic] + 1);
+          continue;
+        }
+        this->emit(selection);
+      }
+    }
+
+  private:
+    int64_t max_interval_{-1}; // Negative: unlimited.
+  };
+
+} // namespace lwrcl
+
+#endif // LWRCL_SYNCHRONIZER_HPP_
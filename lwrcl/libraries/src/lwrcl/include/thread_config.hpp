@@ -0,0 +1,47 @@
+#ifndef LWRCL_THREAD_CONFIG_HPP_
+#define LWRCL_THREAD_CONFIG_HPP_
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lwrcl
+{
+
+  enum class SchedulingPolicy
+  {
+    INHERIT, // Leave the scheduler of the thread untouched.
+    OTHER,   // SCHED_OTHER
+    FIFO,    // SCHED_FIFO
+    RR       // SCHED_RR
+  };
+
+  // Scheduling of a thread lwrcl spawns (executor workers, timer threads, the tf listener thread).
+  // The default leaves the thread exactly as the OS created it.
+  struct ThreadConfig
+  {
+    SchedulingPolicy policy = SchedulingPolicy::INHERIT;
+    int priority = 0;              // 1-99 for FIFO and RR, ignored otherwise.
+    std::vector<int> cpu_affinity; // CPUs the thread may run on; empty leaves the affinity untouched.
+  };
+
+  // Applying a config fails (with a message on std::cerr) when the process lacks the privilege
+  // for real-time scheduling or the CPUs do not exist; the thread keeps running unchanged.
+  bool apply_thread_config(std::thread::native_handle_type thread, const ThreadConfig &config);
+  bool apply_thread_config(std::thread &thread, const ThreadConfig &config);
+  // Applies to the calling thread, e.g. the one running SingleThreadedExecutor::spin().
+  bool apply_thread_config(const ThreadConfig &config);
+
+  // Config applied to every thread lwrcl spawns from now on, unless overridden per object.
+  void set_default_thread_config(const ThreadConfig &config);
+  ThreadConfig get_default_thread_config();
+
+  // mlockall(MCL_CURRENT | MCL_FUTURE), so real-time threads do not take page faults.
+  bool lock_memory();
+
+  // Maps "INHERIT", "OTHER", "FIFO" and "RR" (as used in YAML configs) to a policy.
+  bool parse_scheduling_policy(const std::string &name, SchedulingPolicy &policy);
+
+} // namespace lwrcl
+
+#endif // LWRCL_THREAD_CONFIG_HPP_
@@ -0,0 +1,42 @@
+#ifndef LWRCL_TIME_SOURCE_HPP_
+#define LWRCL_TIME_SOURCE_HPP_
+
+#include <cstdint>
+
+namespace lwrcl
+{
+
+  enum class ClockType
+  {
+    SYSTEM_TIME, // Wall clock (std::chrono::system_clock).
+    ROS_TIME,    // Simulated time while TimeSource is active, SYSTEM_TIME otherwise.
+    STEADY_TIME  // Monotonic clock (std::chrono::steady_clock), never jumps.
+  };
+
+  // Process-wide source of ROS time. While simulated time is active, ROS_TIME clocks, timers of
+  // nodes using ROS_TIME and Rates built on ROS_TIME follow the time last set here (usually by a
+  // /clock subscription, see Node::create_clock_subscription) instead of the wall clock. Time
+  // then only advances when it is set, so it may run faster or slower than real time, or pause.
+  class TimeSource
+  {
+  public:
+    // Switching either way is a time jump: ROS_TIME timers restart their period from the new
+    // time. ROS time reads 0 until the first set_ros_time() after activation.
+    static void set_simulated_time(bool active);
+    static bool is_simulated_time_active();
+
+    // Advances (or rewinds) simulated time and wakes timers and Rates waiting on it. Ignored
+    // while simulated time is not active.
+    static void set_ros_time(int64_t nanoseconds);
+
+    // Nanoseconds since the clock's epoch.
+    static int64_t now(ClockType type);
+
+    // Blocks until ROS time reaches deadline. Returns false without waiting that long when
+    // simulated time is deactivated or lwrcl is shut down meanwhile.
+    static bool sleep_until_ros_time(int64_t deadline);
+  };
+
+} // namespace lwrcl
+
+#endif // LWRCL_TIME_SOURCE_HPP_
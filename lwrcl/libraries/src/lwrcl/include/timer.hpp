@@ -6,13 +6,28 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
 
 #include "fast_dds_header.hpp"
 #include "channel.hpp"
+#include "thread_config.hpp"
+#include "time_source.hpp"
 
 namespace lwrcl
 {
 
+  // Passed to a timer's overrun callback when periods were skipped in coalescing mode.
+  struct TimerOverrunInfo
+  {
+    uint64_t skipped_periods;          // Firings dropped since the callback last ran.
+    std::chrono::nanoseconds lateness; // How long after its due time the pending firing runs.
+  };
+
   class TimerCallback : public ChannelCallback
   {
   public:
@@ -21,10 +36,97 @@ namespace lwrcl
 
     ~TimerCallback() = default;
 
-    void invoke()
+    // Called by the timer service at each expiry. Returns false when the firing is coalesced
+    // into one that is still pending.
+    bool on_fire(std::chrono::steady_clock::time_point due)
+    {
+      if (!coalescing_.load(std::memory_order_relaxed))
+      {
+        return true;
+      }
+      if (pending_.exchange(true))
+      {
+        skipped_since_run_.fetch_add(1, std::memory_order_relaxed);
+        skipped_total_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      pending_due_.store(due.time_since_epoch().count(), std::memory_order_relaxed);
+      return true;
+    }
+
+    // The firing accepted by on_fire was not queued or was evicted.
+    void clear_pending()
+    {
+      pending_.store(false);
+    }
+
+    void discard() override
+    {
+      clear_pending();
+    }
+
+    void set_coalescing(bool enable)
+    {
+      coalescing_.store(enable);
+      if (!enable)
+      {
+        clear_pending();
+      }
+    }
+
+    bool is_coalescing() const
+    {
+      return coalescing_.load();
+    }
+
+    uint64_t get_skipped_periods() const
+    {
+      return skipped_total_.load(std::memory_order_relaxed);
+    }
+
+    void set_overrun_callback(std::function<void(const TimerOverrunInfo &)> overrun_callback)
+    {
+      std::lock_guard<std::mutex> lock(overrun_mutex_);
+      overrun_callback_ = overrun_callback;
+    }
+
+    // Firings still queued when a timer is canceled are dropped when they reach the executor.
+    void set_canceled(bool canceled)
+    {
+      canceled_.store(canceled);
+    }
+
+    bool is_canceled() const
+    {
+      return canceled_.load();
+    }
+
+  protected:
+    void execute() override
     {
+      if (canceled_.load())
+      {
+        clear_pending();
+        return;
+      }
       try
       {
+        if (coalescing_.load(std::memory_order_relaxed))
+        {
+          // Cleared first so an expiry during the callback queues the next run.
+          auto due = std::chrono::steady_clock::time_point(
+              std::chrono::steady_clock::duration(pending_due_.load(std::memory_order_relaxed)));
+          pending_.store(false);
+          uint64_t skipped = skipped_since_run_.exchange(0, std::memory_order_relaxed);
+          if (skipped > 0)
+          {
+            std::lock_guard<std::mutex> lock(overrun_mutex_);
+            if (overrun_callback_)
+            {
+              overrun_callback_(TimerOverrunInfo{skipped, std::chrono::steady_clock::now() - due});
+            }
+          }
+        }
         callback_function_();
       }
       catch (const std::exception &e)
@@ -39,6 +141,14 @@ namespace lwrcl
 
   private:
     std::function<void()> callback_function_;
+    std::atomic<bool> canceled_{false};
+    std::atomic<bool> coalescing_{false};
+    std::atomic<bool> pending_{false}; // A coalesced firing is queued or running.
+    std::atomic<std::chrono::steady_clock::rep> pending_due_{0};
+    std::atomic<uint64_t> skipped_since_run_{0};
+    std::atomic<uint64_t> skipped_total_{0};
+    std::mutex overrun_mutex_;
+    std::function<void(const TimerOverrunInfo &)> overrun_callback_;
   };
 
   class ITimer
@@ -47,12 +157,128 @@ namespace lwrcl
     virtual ~ITimer() = default;
   };
 
+  enum class TimerBackend
+  {
+    SLEEP_UNTIL, // std::this_thread::sleep_until / condition_variable::wait_until.
+    TIMERFD      // Linux timerfd on CLOCK_MONOTONIC with absolute expiries; SLEEP_UNTIL elsewhere.
+  };
+
+  struct TimerBackendOptions
+  {
+    TimerBackend backend = TimerBackend::SLEEP_UNTIL;
+    // The last part of each wait is busy-waited to hide kernel wakeup latency. Costs a core
+    // for this long per wakeup; zero disables it.
+    std::chrono::nanoseconds spin_threshold{0};
+  };
+
+  // Sleeps the calling thread until deadline using the given backend. Used by Rate.
+  void precise_sleep_until(std::chrono::steady_clock::time_point deadline, const TimerBackendOptions &options);
+
+  // Process-wide thread that fires every lwrcl Timer. Expiries are kept in a min-heap ordered
+  // by due time, then by registration order, so timers due at the same instant always fire in
+  // the same order. Fire callbacks run on the service thread and must be short (Timer only
+  // produces its channel entry). ROS_TIME timers have a heap of their own, scheduled in
+  // TimeSource ROS time; all other clock types are scheduled on the steady clock.
+  class TimerService
+  {
+  public:
+    using TimerId = uint64_t;
+
+    static TimerService &instance();
+
+    using FireCallback = std::function<void(std::chrono::steady_clock::time_point due)>;
+
+    // First expiry is one period from now; returns a non-zero id.
+    TimerId add(std::chrono::nanoseconds period, FireCallback fire, ClockType clock_type = ClockType::STEADY_TIME);
+    // When this returns the fire callback is not running and will not run again, unless
+    // called from the fire callback itself.
+    void remove(TimerId id);
+    // Stops firing without unregistering and without waiting; reset() resumes.
+    void cancel(TimerId id);
+    // Restarts the period from now (also resumes a canceled timer).
+    void reset(TimerId id);
+    // The next expiry becomes the previous one plus the new period (now, if that has passed).
+    void set_period(TimerId id, std::chrono::nanoseconds period);
+    // nanoseconds::max() for a canceled or unknown timer; negative while a firing is late.
+    std::chrono::nanoseconds time_until_trigger(TimerId id);
+    size_t size();
+    // Scheduling of the service thread. It starts with get_default_thread_config().
+    bool set_thread_config(const ThreadConfig &config);
+    // How the service thread waits for the next expiry; applies to all timers.
+    void set_backend(const TimerBackendOptions &options);
+
+    // Called by TimeSource. After a jump ROS_TIME timers restart their period from the new time.
+    void on_ros_time_jump();
+    void on_ros_time_update();
+
+  private:
+    struct Entry
+    {
+      std::chrono::nanoseconds period;
+      std::chrono::steady_clock::time_point due; // Steady timers.
+      int64_t ros_due;                           // ROS_TIME timers, in TimeSource::now(ROS_TIME).
+      std::shared_ptr<FireCallback> fire;
+      bool active;
+      bool ros_time;
+    };
+
+    struct Expiry
+    {
+      std::chrono::steady_clock::time_point due;
+      TimerId id;
+
+      bool operator>(const Expiry &rhs) const
+      {
+        return due > rhs.due || (due == rhs.due && id > rhs.id);
+      }
+    };
+
+    struct RosExpiry
+    {
+      int64_t due;
+      TimerId id;
+
+      bool operator>(const RosExpiry &rhs) const
+      {
+        return due > rhs.due || (due == rhs.due && id > rhs.id);
+      }
+    };
+
+    TimerService() = default;
+    void run();
+    // Sets the first expiry one period from now on the timer's clock. Requires mutex_.
+    void schedule_from_now(TimerId id, Entry &entry);
+    bool is_stale(const Expiry &expiry) const;
+    bool is_stale(const RosExpiry &expiry) const;
+    // Advances the timer past due and calls its fire callback without mutex_ held.
+    void fire(std::unique_lock<std::mutex> &lock, TimerId id, std::chrono::steady_clock::time_point due);
+    void wait_for_expiry(std::unique_lock<std::mutex> &lock, std::chrono::steady_clock::time_point due);
+    void wake();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;       // Wakes the service thread for a new earliest expiry.
+    std::condition_variable fired_cv_; // Signalled after each fire, for remove().
+    std::unordered_map<TimerId, Entry> timers_;
+    // Stale expiries (removed timers, rescheduled entries) are skipped when they surface.
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>> expiries_;
+    std::priority_queue<RosExpiry, std::vector<RosExpiry>, std::greater<RosExpiry>> ros_expiries_;
+    TimerId next_id_{1};
+    TimerId firing_{0};
+    std::thread worker_;
+    TimerBackendOptions backend_;
+    int timer_fd_{-1}; // Created on first use of TimerBackend::TIMERFD.
+    int wake_fd_{-1};  // eventfd interrupting a timerfd wait when an earlier expiry is added.
+  };
+
   template <typename DurationType>
   class Timer : public ITimer
   {
   public:
-    Timer(DurationType period, std::function<void()> callback_function, Channel<ChannelCallback *> &channel)
-        : period_(period), channel_(channel), stop_flag_(false)
+    // ROS_TIME timers follow TimeSource; other clock types fire on the steady clock.
+    Timer(DurationType period, std::function<void()> callback_function, Channel<ChannelCallback *> &channel,
+          ClockType clock_type = ClockType::STEADY_TIME)
+        : period_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(period).count()), channel_(channel),
+          clock_type_(clock_type)
     {
       timer_callback_ = std::make_unique<TimerCallback>(callback_function);
       start();
@@ -65,36 +291,149 @@ namespace lwrcl
 
     void start()
     {
-
-      worker_ = std::thread([this]()
-                            { run(); });
+      TimerService::TimerId id = TimerService::instance().add(
+          std::chrono::nanoseconds(period_ns_.load()),
+          [this](std::chrono::steady_clock::time_point due)
+          { fire(due); },
+          clock_type_);
+      TimerService::TimerId expected = 0;
+      if (!timer_id_.compare_exchange_strong(expected, id))
+      {
+        TimerService::instance().remove(id); // Already running.
+        return;
+      }
+      timer_callback_->set_canceled(false);
     }
 
+    // Unregisters the timer and waits for an in-flight expiry; start() registers it again.
     void stop()
     {
-      stop_flag_ = true;
-      if (worker_.joinable())
+      TimerService::TimerId id = timer_id_.exchange(0);
+      if (id != 0)
+      {
+        TimerService::instance().remove(id);
+      }
+    }
+
+    // Stops the timer without tearing anything down; firings already queued are dropped.
+    // Safe to call from any callback, including the timer's own.
+    void cancel()
+    {
+      timer_callback_->set_canceled(true);
+      TimerService::TimerId id = timer_id_.load();
+      if (id != 0)
+      {
+        TimerService::instance().cancel(id);
+      }
+    }
+
+    // Restarts the period from now, resuming a canceled timer.
+    void reset()
+    {
+      TimerService::TimerId id = timer_id_.load();
+      if (id != 0)
+      {
+        timer_callback_->set_canceled(false);
+        TimerService::instance().reset(id);
+      }
+    }
+
+    bool is_canceled() const
+    {
+      return timer_id_.load() == 0 || timer_callback_->is_canceled();
+    }
+
+    // Time until the next expiry, measured on the timer's clock; nanoseconds::max() when
+    // canceled or stopped.
+    std::chrono::nanoseconds time_until_trigger()
+    {
+      TimerService::TimerId id = timer_id_.load();
+      if (id == 0 || timer_callback_->is_canceled())
+      {
+        return std::chrono::nanoseconds::max();
+      }
+      return TimerService::instance().time_until_trigger(id);
+    }
+
+    // Takes effect from the next expiry, which becomes the previous expiry plus the new period.
+    void set_period(DurationType period)
+    {
+      auto period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(period);
+      period_ns_.store(period_ns.count());
+      TimerService::TimerId id = timer_id_.load();
+      if (id != 0)
       {
-        worker_.join(); // Wait for the worker thread to finish
+        TimerService::instance().set_period(id, period_ns);
       }
     }
 
+    DurationType get_period() const
+    {
+      return std::chrono::duration_cast<DurationType>(std::chrono::nanoseconds(period_ns_.load()));
+    }
+
+    // Dispatch priority of this timer's callback (see ChannelOptions::priority_dispatch).
+    void set_priority(int priority)
+    {
+      timer_callback_->set_priority(priority);
+    }
+
+    int get_priority() const
+    {
+      return timer_callback_->get_priority();
+    }
+
+    // Scheduling of the shared timer service thread, so it applies to all timers.
+    bool set_thread_config(const ThreadConfig &config)
+    {
+      return TimerService::instance().set_thread_config(config);
+    }
+
+    ChannelCallback *get_channel_callback()
+    {
+      return timer_callback_.get();
+    }
+
+    // In coalescing mode at most one firing of this timer is pending in the channel; expiries
+    // while it is pending are skipped and counted instead of piling up.
+    void set_coalescing(bool enable)
+    {
+      timer_callback_->set_coalescing(enable);
+    }
+
+    bool is_coalescing() const
+    {
+      return timer_callback_->is_coalescing();
+    }
+
+    // Total periods skipped in coalescing mode.
+    uint64_t get_skipped_periods() const
+    {
+      return timer_callback_->get_skipped_periods();
+    }
+
+    // Runs on the executor, just before the timer callback, when periods were skipped.
+    void set_overrun_callback(std::function<void(const TimerOverrunInfo &)> overrun_callback)
+    {
+      timer_callback_->set_overrun_callback(overrun_callback);
+    }
+
   private:
-    void run()
+    // Runs on the timer service thread shared by every timer, so it never blocks: a full
+    // OverflowPolicy::BLOCK channel drops the expiry, which is counted like any other drop.
+    void fire(std::chrono::steady_clock::time_point due)
     {
-      auto next_execution_time = std::chrono::steady_clock::now() + period_;
-      while (!stop_flag_)
+      if (timer_callback_->on_fire(due) && !channel_.try_produce(timer_callback_.get()))
       {
-        std::this_thread::sleep_until(next_execution_time);
-        channel_.produce(timer_callback_.get());
-        next_execution_time += period_; // Schedule next execution
+        timer_callback_->clear_pending();
       }
     }
-    bool stop_flag_;
-    DurationType period_;
+
+    std::atomic<int64_t> period_ns_;
     std::unique_ptr<TimerCallback> timer_callback_;
-    std::thread worker_;
     Channel<ChannelCallback *> &channel_;
+    ClockType clock_type_;
+    std::atomic<TimerService::TimerId> timer_id_{0};
   };
 
 } // namespace lwrcl
@@ -0,0 +1,58 @@
+#ifndef LWRCL_WAIT_SET_HPP_
+#define LWRCL_WAIT_SET_HPP_
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "fast_dds_header.hpp"
+#include "channel.hpp"
+
+namespace lwrcl
+{
+
+  // Blocks an executor thread on a DDS WaitSet holding the read conditions of its wait-set
+  // subscriptions (see SubscriptionOptions::wait_set) and a guard condition that
+  // EventNotifier::notify() triggers, so the thread wakes for either. Installed as the
+  // notifier's ExternalWaiter by get_wait_set_waiter().
+  class WaitSetWaiter : public ExternalWaiter
+  {
+  public:
+    // Called on the waiting thread when the condition triggers; returns false when the
+    // subscription could not queue its entry, to be retried on the next wait().
+    using Handler = std::function<bool()>;
+
+    WaitSetWaiter();
+    ~WaitSetWaiter() override;
+
+    void wait() override;
+    void wake() override;
+
+    // A triggered condition is detached until rearm(), so it is reported once per entry.
+    void attach(dds::ReadCondition *condition, Handler handler);
+    void rearm(dds::ReadCondition *condition);
+    // No handler runs for condition after this returns.
+    void detach(dds::ReadCondition *condition);
+
+  private:
+    struct Attachment
+    {
+      Handler handler;
+      bool attached;
+    };
+
+    dds::WaitSet wait_set_;
+    dds::GuardCondition guard_;
+    std::mutex mutex_;
+    std::map<dds::Condition *, Attachment> attachments_;
+    std::vector<dds::Condition *> retries_; // Handlers that returned false.
+    dds::ConditionSeq triggered_;
+  };
+
+  // The WaitSetWaiter of notifier, installed on first use.
+  WaitSetWaiter *get_wait_set_waiter(EventNotifier &notifier);
+
+} // namespace lwrcl
+
+#endif // LWRCL_WAIT_SET_HPP_
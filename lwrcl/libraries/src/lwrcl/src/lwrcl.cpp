@@ -6,9 +6,20 @@
 #include <mutex>
 #include <algorithm>
 #include <functional>
+#include <map>
 #include <memory>
 #include <chrono>
 #include <vector>
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif
 #include "lwrcl.hpp" // The main header file for the lwrcl namespace
 
 namespace lwrcl
@@ -78,6 +89,11 @@ namespace lwrcl
   SingleThreadedExecutor::~SingleThreadedExecutor()
   {
     stop_spin();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto node : nodes_)
+    {
+      node->set_event_notifier(nullptr);
+    }
   }
 
   void SingleThreadedExecutor::add_node(Node *node)
@@ -86,6 +102,8 @@ namespace lwrcl
     if (node != nullptr)
     {
       nodes_.push_back(node);
+      node->set_event_notifier(&notifier_);
+      notifier_.notify(); // Let a running spin() pick up work queued before the node was added.
     }
     else
     {
@@ -98,12 +116,14 @@ namespace lwrcl
     std::lock_guard<std::mutex> lock(mutex_);
     if (node != nullptr)
     {
+      node->set_event_notifier(nullptr);
       nodes_.erase(std::remove(nodes_.begin(), nodes_.end(), node), nodes_.end());
     }
   }
 
   void SingleThreadedExecutor::stop_spin()
   {
+    stop_flag_ = true;
     std::lock_guard<std::mutex> lock(mutex_);
     for (auto &node : nodes_)
     {
@@ -116,25 +136,35 @@ namespace lwrcl
         std::cerr << "node pointer is invalid!" << std::endl;
       }
     }
+    notifier_.notify();
   }
 
   void SingleThreadedExecutor::spin()
   {
-    while (!global_stop_flag.load())
+    while (!global_stop_flag.load() && !stop_flag_.load())
     {
-      std::lock_guard<std::mutex> lock(mutex_);
-      for (auto node : nodes_)
+      // Read the epoch before polling so anything produced while the nodes are being
+      // serviced makes the wait below return immediately.
+      uint64_t epoch = notifier_.get_epoch();
       {
-        if (node)
-        {
-          node->spin_some();
-        }
-        else
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto node : nodes_)
         {
-          std::cerr << "node pointer is invalid!" << std::endl;
+          if (node)
+          {
+            node->spin_some();
+          }
+          else
+          {
+            std::cerr << "node pointer is invalid!" << std::endl;
+          }
         }
       }
-      std::this_thread::sleep_for(std::chrono::microseconds(10));
+      if (global_stop_flag.load() || stop_flag_.load())
+      {
+        break;
+      }
+      notifier_.wait(epoch);
     }
   }
 
@@ -156,23 +186,31 @@ namespace lwrcl
 
   void SingleThreadedExecutor::shutdown()
   {
-    std::lock_guard<std::mutex> lock(mutex_);
     stop_spin();
   }
 
-  MultiThreadedExecutor::MultiThreadedExecutor() {}
+  StaticSingleThreadedExecutor::StaticSingleThreadedExecutor() {}
 
-  MultiThreadedExecutor::~MultiThreadedExecutor()
+  StaticSingleThreadedExecutor::~StaticSingleThreadedExecutor()
   {
     stop_spin();
+    std::lock_guard<std::mutex> lock(mutex_);
+    release_dispatch_table();
+    for (auto node : nodes_)
+    {
+      node->set_event_notifier(nullptr);
+    }
   }
 
-  void MultiThreadedExecutor::add_node(Node *node)
+  void StaticSingleThreadedExecutor::add_node(Node *node)
   {
     std::lock_guard<std::mutex> lock(mutex_);
     if (node != nullptr)
     {
+      release_dispatch_table(); // Rebuilt on the next spin.
       nodes_.push_back(node);
+      node->set_event_notifier(&notifier_);
+      notifier_.notify();
     }
     else
     {
@@ -180,19 +218,23 @@ namespace lwrcl
     }
   }
 
-  void MultiThreadedExecutor::remove_node(Node *node)
+  void StaticSingleThreadedExecutor::remove_node(Node *node)
   {
     std::lock_guard<std::mutex> lock(mutex_);
     if (node != nullptr)
     {
+      release_dispatch_table();
+      node->set_event_notifier(nullptr);
       nodes_.erase(std::remove(nodes_.begin(), nodes_.end(), node), nodes_.end());
+      notifier_.notify();
     }
   }
 
-  void MultiThreadedExecutor::stop_spin()
+  void StaticSingleThreadedExecutor::stop_spin()
   {
+    stop_flag_ = true;
     std::lock_guard<std::mutex> lock(mutex_);
-    for (auto node : nodes_)
+    for (auto &node : nodes_)
     {
       if (node)
       {
@@ -203,32 +245,177 @@ namespace lwrcl
         std::cerr << "node pointer is invalid!" << std::endl;
       }
     }
+    notifier_.notify();
+  }
 
-    for (auto &thread : threads_)
+  void StaticSingleThreadedExecutor::spin()
+  {
+    while (!global_stop_flag.load() && !stop_flag_.load())
     {
-      if (thread.joinable())
+      uint64_t epoch = notifier_.get_epoch();
       {
-        thread.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!table_built_)
+        {
+          build_dispatch_table();
+        }
+        execute_ready();
       }
+      if (global_stop_flag.load() || stop_flag_.load())
+      {
+        break;
+      }
+      notifier_.wait(epoch);
     }
-    threads_.clear();
   }
 
-  void MultiThreadedExecutor::spin()
+  void StaticSingleThreadedExecutor::spin_some()
   {
     std::lock_guard<std::mutex> lock(mutex_);
+    if (!table_built_)
+    {
+      build_dispatch_table();
+    }
+    execute_ready();
+  }
+
+  void StaticSingleThreadedExecutor::shutdown()
+  {
+    stop_spin();
+  }
+
+  // Requires mutex_.
+  void StaticSingleThreadedExecutor::build_dispatch_table()
+  {
+    release_dispatch_table();
     for (auto node : nodes_)
     {
-      threads_.emplace_back([this, node]()
-                            {
-        if (!node)
+      node->for_each_callback_group(
+          [this](CallbackGroup *group)
+          {
+            Channel<ChannelCallback *> &channel = group->get_channel();
+            for (auto callback : group->get_callbacks())
+            {
+              dispatch_table_.push_back(DispatchEntry{callback, &channel});
+            }
+            channels_.push_back(&channel);
+            channel.set_direct_dispatch(true);
+          });
+    }
+    table_built_ = true;
+  }
+
+  // Requires mutex_. Hands callbacks that are still pending back to their channels so
+  // Node::spin or another executor can run them.
+  void StaticSingleThreadedExecutor::release_dispatch_table()
+  {
+    for (auto channel : channels_)
+    {
+      channel->set_direct_dispatch(false);
+    }
+    for (auto &entry : dispatch_table_)
+    {
+      for (uint32_t n = entry.callback->take_ready(); n > 0; --n)
+      {
+        ChannelCallback *callback = entry.callback;
+        if (!entry.channel->requeue(std::move(callback)))
         {
-          std::cerr << "node pointer is invalid!" << std::endl;
+          discard_channel_entry(entry.callback);
         }
-        else
-        {
-          node->spin();
-        } });
+      }
+    }
+    dispatch_table_.clear();
+    channels_.clear();
+    table_built_ = false;
+  }
+
+  // Requires mutex_. Walks the table in its fixed order; returns the number of invocations.
+  size_t StaticSingleThreadedExecutor::execute_ready()
+  {
+    size_t executed = 0;
+    for (auto &entry : dispatch_table_)
+    {
+      for (uint32_t n = entry.callback->take_ready(); n > 0; --n)
+      {
+        entry.callback->invoke();
+        ++executed;
+      }
+    }
+    return executed;
+  }
+
+  MultiThreadedExecutor::MultiThreadedExecutor(size_t number_of_threads)
+      : number_of_threads_(number_of_threads), thread_config_(get_default_thread_config())
+  {
+    if (number_of_threads_ == 0)
+    {
+      number_of_threads_ = std::max(2u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < number_of_threads_; ++i)
+    {
+      work_queues_.push_back(std::make_unique<WorkQueue>());
+    }
+  }
+
+  MultiThreadedExecutor::~MultiThreadedExecutor()
+  {
+    stop_spin();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto node : nodes_)
+    {
+      node->set_event_notifier(nullptr);
+    }
+  }
+
+  void MultiThreadedExecutor::add_node(Node *node)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (node != nullptr)
+    {
+      nodes_.push_back(node);
+      node->set_event_notifier(&notifier_);
+      notifier_.notify();
+    }
+    else
+    {
+      std::cerr << "Error: Node pointer is null, cannot add to executor." << std::endl;
+    }
+  }
+
+  void MultiThreadedExecutor::remove_node(Node *node)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (node != nullptr)
+    {
+      node->set_event_notifier(nullptr);
+      nodes_.erase(std::remove(nodes_.begin(), nodes_.end(), node), nodes_.end());
+    }
+  }
+
+  void MultiThreadedExecutor::stop_spin()
+  {
+    stop_flag_ = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto node : nodes_)
+    {
+      node->stop_spin();
+    }
+    notifier_.notify();
+  }
+
+  void MultiThreadedExecutor::spin()
+  {
+    ThreadConfig thread_config;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      thread_config = thread_config_;
+    }
+    for (size_t i = 0; i < number_of_threads_; ++i)
+    {
+      threads_.emplace_back([this, i, thread_config]()
+                            {
+                              apply_thread_config(thread_config);
+                              worker_loop(i); });
     }
 
     for (auto &thread : threads_)
@@ -238,6 +425,32 @@ namespace lwrcl
         thread.join();
       }
     }
+    threads_.clear();
+
+    // Release work that was taken but never run: claimed groups become available again and
+    // reentrant callbacks are discarded so their buffered messages do not linger.
+    for (auto &queue : work_queues_)
+    {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      for (auto &task : queue->tasks)
+      {
+        if (task.callback)
+        {
+          discard_channel_entry(task.callback);
+        }
+        else
+        {
+          task.group->release();
+        }
+      }
+      queue->tasks.clear();
+    }
+  }
+
+  void MultiThreadedExecutor::set_thread_config(const ThreadConfig &config)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_config_ = config;
   }
 
   void MultiThreadedExecutor::spin_some()
@@ -245,21 +458,124 @@ namespace lwrcl
     std::lock_guard<std::mutex> lock(mutex_);
     for (auto node : nodes_)
     {
-      if (node)
+      node->spin_some();
+    }
+  }
+
+  void MultiThreadedExecutor::shutdown()
+  {
+    stop_spin();
+  }
+
+  size_t MultiThreadedExecutor::get_number_of_threads() const
+  {
+    return number_of_threads_;
+  }
+
+  void MultiThreadedExecutor::worker_loop(size_t index)
+  {
+    while (!global_stop_flag.load() && !stop_flag_.load())
+    {
+      Task task;
+      if (pop_task(index, task))
       {
-        node->spin_some();
+        run_task(task);
+        continue;
       }
-      else
+
+      // Read the epoch before scanning so work queued during the scan is not slept through.
+      uint64_t epoch = notifier_.get_epoch();
+      size_t collected = collect_ready_work(index);
+      if (collected > 1)
       {
-        std::cerr << "node pointer is invalid!" << std::endl;
+        notifier_.notify(); // Wake idle workers so they steal the surplus.
+      }
+      if (collected > 0)
+      {
+        continue;
+      }
+      if (global_stop_flag.load() || stop_flag_.load())
+      {
+        break;
       }
+      notifier_.wait(epoch);
     }
   }
 
-  void MultiThreadedExecutor::shutdown()
+  bool MultiThreadedExecutor::pop_task(size_t index, Task &task)
+  {
+    {
+      WorkQueue &own = *work_queues_[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty())
+      {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+      }
+    }
+
+    for (size_t offset = 1; offset < work_queues_.size(); ++offset)
+    {
+      WorkQueue &victim = *work_queues_[(index + offset) % work_queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty())
+      {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  size_t MultiThreadedExecutor::collect_ready_work(size_t index)
   {
+    size_t collected = 0;
     std::lock_guard<std::mutex> lock(mutex_);
-    stop_spin();
+    WorkQueue &own = *work_queues_[index];
+    // Start at a per-worker offset so workers do not all contend for the first node.
+    for (size_t i = 0; i < nodes_.size(); ++i)
+    {
+      nodes_[(index + i) % nodes_.size()]->for_each_callback_group(
+          [&](CallbackGroup *group)
+          {
+            Channel<ChannelCallback *> &channel = group->get_channel();
+            if (group->type() == CallbackGroupType::Reentrant)
+            {
+              // Split the batch into single callbacks so idle workers can steal them. With
+              // priority dispatch only the head is taken so later arrivals can still overtake.
+              std::lock_guard<std::mutex> queue_lock(own.mutex);
+              ChannelCallback *callback = nullptr;
+              size_t limit = channel.get_batch_limit();
+              for (size_t taken = 0; taken < limit && channel.consume_nowait(callback); ++taken)
+              {
+                own.tasks.push_back(Task{group, callback});
+                ++collected;
+              }
+              return;
+            }
+            if (group->is_claimed() || channel.empty() || !group->try_claim())
+            {
+              return;
+            }
+            std::lock_guard<std::mutex> queue_lock(own.mutex);
+            own.tasks.push_back(Task{group, nullptr});
+            ++collected;
+          });
+    }
+    return collected;
+  }
+
+  void MultiThreadedExecutor::run_task(const Task &task)
+  {
+    if (task.callback)
+    {
+      task.callback->invoke();
+      return;
+    }
+    task.group->spin_some();
+    task.group->release();
   }
 
   Time::Time() : nanoseconds_(0) {}
@@ -295,129 +611,491 @@ namespace lwrcl
   Clock::Clock(ClockType type) : type_(type) {}
   Time Clock::now()
   {
-    switch (type_)
-    {
-    case ClockType::SYSTEM_TIME:
-      return Time(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                      std::chrono::system_clock::now().time_since_epoch())
-                      .count());
-    default:
-      throw std::runtime_error("Unsupported clock type.");
-    }
+    return Time(TimeSource::now(type_));
   }
   Clock::ClockType Clock::get_clock_type() const { return type_; }
 
-  // Rate implementation
-  Rate::Rate(const Duration &period) : period_(period), next_time_(std::chrono::steady_clock::now() + std::chrono::nanoseconds(period.nanoseconds())) {}
-  void Rate::sleep()
-  {
-    auto now = std::chrono::steady_clock::now();
-    if (now >= next_time_)
-    {
-      auto periods_missed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - next_time_) / std::chrono::nanoseconds(period_.nanoseconds()) + 1;
-      next_time_ += periods_missed * std::chrono::nanoseconds(period_.nanoseconds());
-    }
-    std::this_thread::sleep_until(next_time_);
-    next_time_ += std::chrono::nanoseconds(period_.nanoseconds());
-  }
-
-  Node::Node(int domain_id) : clock_(std::make_unique<Clock>())
+  // TimeSource implementation
+  namespace
   {
-    dds::DomainParticipantQos participant_qos = dds::PARTICIPANT_QOS_DEFAULT;
+    std::atomic<bool> simulated_time_active{false};
+    std::atomic<int64_t> simulated_time{0};
 
-    // Create a descriptor for the new transport.
-    auto udp_transport = std::make_shared<eprosima::fastdds::rtps::UDPv4TransportDescriptor>();
-    udp_transport->sendBufferSize = 4194304;
-    udp_transport->receiveBufferSize = 4194304;
-    udp_transport->non_blocking_send = true;
-
-    // Link the Transport Layer to the Participant.
-    participant_qos.transport().user_transports.push_back(udp_transport);
-
-    // Increase the sending buffer size
-    participant_qos.transport().send_socket_buffer_size = 4194304;
-    // Increase the receiving buffer size
-    participant_qos.transport().listen_socket_buffer_size = 4194304;
-
-    // eprosima::fastdds::dds::Log::SetVerbosity(eprosima::fastdds::dds::Log::Info);
-
-    auto participant_factory = eprosima::fastdds::dds::DomainParticipantFactory::get_instance();
-    participant_factory->load_XML_profiles_file("/opt/fast-dds/fastdds.xml");
+    struct RosTimeWaiters
+    {
+      std::mutex mutex;
+      std::condition_variable cv;
+    };
 
-    participant_ = std::shared_ptr<eprosima::fastdds::dds::DomainParticipant>(
-    eprosima::fastdds::dds::DomainParticipantFactory::get_instance()->create_participant(domain_id, participant_qos),
-    DomainParticipantDeleter());
-    if (!participant_)
+    RosTimeWaiters &ros_time_waiters()
     {
-      throw std::runtime_error("Failed to create domain participant");
+      static RosTimeWaiters *waiters = new RosTimeWaiters();
+      return *waiters;
     }
 
-    get_global_registry().add_node(this);
+    void notify_ros_time_waiters()
+    {
+      RosTimeWaiters &waiters = ros_time_waiters();
+      {
+        std::lock_guard<std::mutex> lock(waiters.mutex); // Orders the update before a waiter's check.
+      }
+      waiters.cv.notify_all();
+    }
   }
 
-  Node::Node(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant) : clock_(std::make_unique<Clock>()), participant_(participant)
+  void TimeSource::set_simulated_time(bool active)
   {
-    if (!participant_)
+    if (simulated_time_active.load() == active)
     {
-      throw std::runtime_error("Failed to create domain participant");
+      return;
     }
-
-    get_global_registry().add_node(this);
+    simulated_time.store(0);
+    simulated_time_active.store(active);
+    notify_ros_time_waiters();
+    TimerService::instance().on_ros_time_jump();
   }
 
-  Node::~Node()
+  bool TimeSource::is_simulated_time_active()
   {
-    publisher_list_.clear();
-    subscription_list_.clear();
-    timer_list_.clear();
+    return simulated_time_active.load();
   }
 
-  std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> Node::get_participant() const
+  void TimeSource::set_ros_time(int64_t nanoseconds)
   {
-    return participant_;
+    if (!simulated_time_active.load())
+    {
+      return;
+    }
+    int64_t previous = simulated_time.exchange(nanoseconds);
+    notify_ros_time_waiters();
+    if (nanoseconds < previous)
+    {
+      TimerService::instance().on_ros_time_jump();
+    }
+    else
+    {
+      TimerService::instance().on_ros_time_update();
+    }
   }
 
-  void Node::spin()
+  int64_t TimeSource::now(ClockType type)
   {
-    while (!channel_.is_closed() && !global_stop_flag.load())
+    switch (type)
     {
-      ChannelCallback *callback;
-      while (channel_.consume(callback))
+    case ClockType::ROS_TIME:
+      if (simulated_time_active.load())
       {
-        if (callback)
-        {
-          callback->invoke();
-        }
+        return simulated_time.load();
       }
+      return now(ClockType::SYSTEM_TIME);
+    case ClockType::SYSTEM_TIME:
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+          .count();
+    case ClockType::STEADY_TIME:
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+    default:
+      throw std::runtime_error("Unsupported clock type.");
     }
-    channel_.close();
   }
 
-  void Node::spin_some()
+  bool TimeSource::sleep_until_ros_time(int64_t deadline)
   {
-    bool event_processed = false;
-
-    do
+    if (!simulated_time_active.load())
     {
-      event_processed = false;
-
-      ChannelCallback *callback;
-      while (channel_.consume_nowait(callback))
-      {
-        callback->invoke();
-        event_processed = true;
-      }
-    } while (event_processed);
+      std::this_thread::sleep_until(std::chrono::system_clock::time_point(
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(deadline))));
+      return true;
+    }
+    RosTimeWaiters &waiters = ros_time_waiters();
+    std::unique_lock<std::mutex> lock(waiters.mutex);
+    // The timeout only bounds how late a shutdown is noticed.
+    while (simulated_time_active.load() && simulated_time.load() < deadline && !global_stop_flag.load())
+    {
+      waiters.cv.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    return simulated_time_active.load() && simulated_time.load() >= deadline;
   }
 
-  void Node::stop_spin()
+  // WaitSetWaiter implementation
+  WaitSetWaiter::WaitSetWaiter()
   {
-    channel_.close();
+    wait_set_.attach_condition(guard_);
   }
 
-  void Node::shutdown()
+  WaitSetWaiter::~WaitSetWaiter()
   {
-    channel_.close();
+    wait_set_.detach_condition(guard_);
+  }
+
+  // Only one thread at a time (see EventNotifier::wait).
+  void WaitSetWaiter::wait()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto condition : retries_)
+      {
+        auto it = attachments_.find(condition);
+        if (it != attachments_.end() && !it->second.attached)
+        {
+          wait_set_.attach_condition(*condition);
+          it->second.attached = true;
+        }
+      }
+      retries_.clear();
+    }
+
+    triggered_.clear();
+    if (wait_set_.wait(triggered_, eprosima::fastrtps::c_TimeInfinite) != ReturnCode_t::RETCODE_OK)
+    {
+      return;
+    }
+    // Reset only after waking: a wake() racing with the reset already moved the notifier's
+    // epoch, so the caller polls before waiting again.
+    guard_.set_trigger_value(false);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto condition : triggered_)
+    {
+      auto it = attachments_.find(condition);
+      if (it == attachments_.end() || !it->second.attached)
+      {
+        continue;
+      }
+      wait_set_.detach_condition(*condition);
+      it->second.attached = false;
+      if (!it->second.handler())
+      {
+        retries_.push_back(condition);
+      }
+    }
+  }
+
+  void WaitSetWaiter::wake()
+  {
+    guard_.set_trigger_value(true);
+  }
+
+  void WaitSetWaiter::attach(dds::ReadCondition *condition, Handler handler)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    attachments_[condition] = Attachment{std::move(handler), true};
+    wait_set_.attach_condition(*condition);
+  }
+
+  void WaitSetWaiter::rearm(dds::ReadCondition *condition)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = attachments_.find(condition);
+    if (it != attachments_.end() && !it->second.attached)
+    {
+      wait_set_.attach_condition(*condition);
+      it->second.attached = true;
+    }
+  }
+
+  void WaitSetWaiter::detach(dds::ReadCondition *condition)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = attachments_.find(condition);
+    if (it == attachments_.end())
+    {
+      return;
+    }
+    if (it->second.attached)
+    {
+      wait_set_.detach_condition(*condition);
+    }
+    attachments_.erase(it);
+    retries_.erase(std::remove(retries_.begin(), retries_.end(), condition), retries_.end());
+  }
+
+  WaitSetWaiter *get_wait_set_waiter(EventNotifier &notifier)
+  {
+    ExternalWaiter *waiter = notifier.get_external_waiter();
+    if (waiter == nullptr)
+    {
+      waiter = notifier.set_external_waiter(std::make_unique<WaitSetWaiter>());
+    }
+    return dynamic_cast<WaitSetWaiter *>(waiter);
+  }
+
+  // IntraProcessTopic implementation
+  std::shared_ptr<IntraProcessTopic> IntraProcessTopic::get(dds::DomainParticipant *participant, const std::string &topic)
+  {
+    static std::mutex mutex;
+    static std::map<std::pair<dds::DomainParticipant *, std::string>, std::weak_ptr<IntraProcessTopic>> topics;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<IntraProcessTopic> &entry = topics[std::make_pair(participant, topic)];
+    std::shared_ptr<IntraProcessTopic> shared = entry.lock();
+    if (!shared)
+    {
+      // Topics whose endpoints are all gone are forgotten when a new one is created.
+      for (auto it = topics.begin(); it != topics.end();)
+      {
+        if (it->second.expired() && &it->second != &entry)
+        {
+          it = topics.erase(it);
+        }
+        else
+        {
+          ++it;
+        }
+      }
+      shared = std::make_shared<IntraProcessTopic>();
+      entry = shared;
+    }
+    return shared;
+  }
+
+  // Rate implementation
+  Rate::Rate(const Duration &period, const TimerBackendOptions &backend) : Rate(period, ClockType::STEADY_TIME, backend) {}
+  Rate::Rate(const Duration &period, ClockType clock_type, const TimerBackendOptions &backend)
+      : period_(period), next_time_(std::chrono::steady_clock::now() + std::chrono::nanoseconds(period.nanoseconds())),
+        next_ros_time_(0), clock_type_(clock_type), backend_(backend) {}
+  void Rate::sleep()
+  {
+    if (clock_type_ == ClockType::ROS_TIME && TimeSource::is_simulated_time_active())
+    {
+      int64_t period = std::max<int64_t>(period_.nanoseconds(), 1);
+      int64_t now = TimeSource::now(ClockType::ROS_TIME);
+      if (next_ros_time_ == 0 || next_ros_time_ - now > period)
+      {
+        next_ros_time_ = now + period; // First sleep on simulated time, or time jumped back.
+      }
+      else if (now >= next_ros_time_)
+      {
+        next_ros_time_ += (now - next_ros_time_) / period * period + period;
+      }
+      TimeSource::sleep_until_ros_time(next_ros_time_);
+      next_ros_time_ += period;
+      return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next_time_)
+    {
+      auto periods_missed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - next_time_) / std::chrono::nanoseconds(period_.nanoseconds()) + 1;
+      next_time_ += periods_missed * std::chrono::nanoseconds(period_.nanoseconds());
+    }
+    precise_sleep_until(next_time_, backend_);
+    next_time_ += std::chrono::nanoseconds(period_.nanoseconds());
+  }
+
+  Node::Node(int domain_id, const NodeOptions &options) : options_(options), clock_(std::make_unique<Clock>(options.clock_type))
+  {
+    dds::DomainParticipantQos participant_qos = dds::PARTICIPANT_QOS_DEFAULT;
+
+    // Create a descriptor for the new transport.
+    auto udp_transport = std::make_shared<eprosima::fastdds::rtps::UDPv4TransportDescriptor>();
+    udp_transport->sendBufferSize = 4194304;
+    udp_transport->receiveBufferSize = 4194304;
+    udp_transport->non_blocking_send = true;
+
+    // Link the Transport Layer to the Participant.
+    participant_qos.transport().user_transports.push_back(udp_transport);
+
+    // Increase the sending buffer size
+    participant_qos.transport().send_socket_buffer_size = 4194304;
+    // Increase the receiving buffer size
+    participant_qos.transport().listen_socket_buffer_size = 4194304;
+
+    // eprosima::fastdds::dds::Log::SetVerbosity(eprosima::fastdds::dds::Log::Info);
+
+    auto participant_factory = eprosima::fastdds::dds::DomainParticipantFactory::get_instance();
+    participant_factory->load_XML_profiles_file("/opt/fast-dds/fastdds.xml");
+
+    participant_ = std::shared_ptr<eprosima::fastdds::dds::DomainParticipant>(
+    eprosima::fastdds::dds::DomainParticipantFactory::get_instance()->create_participant(domain_id, participant_qos),
+    DomainParticipantDeleter());
+    if (!participant_)
+    {
+      throw std::runtime_error("Failed to create domain participant");
+    }
+
+    callback_groups_.push_back(std::make_unique<CallbackGroup>(CallbackGroupType::MutuallyExclusive, options_.channel_options));
+    get_global_registry().add_node(this);
+    start_statistics_dump();
+  }
+
+  Node::Node(std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> participant, const NodeOptions &options)
+      : participant_(participant), options_(options), clock_(std::make_unique<Clock>(options.clock_type))
+  {
+    if (!participant_)
+    {
+      throw std::runtime_error("Failed to create domain participant");
+    }
+
+    callback_groups_.push_back(std::make_unique<CallbackGroup>(CallbackGroupType::MutuallyExclusive, options_.channel_options));
+    get_global_registry().add_node(this);
+    start_statistics_dump();
+  }
+
+  Node::~Node()
+  {
+    {
+      std::lock_guard<std::mutex> lock(statistics_dump_mutex_);
+      statistics_dump_stop_ = true;
+    }
+    statistics_dump_cv_.notify_all();
+    if (statistics_dump_thread_.joinable())
+    {
+      statistics_dump_thread_.join();
+    }
+    publisher_list_.clear();
+    subscription_list_.clear();
+    timer_list_.clear();
+  }
+
+  std::shared_ptr<eprosima::fastdds::dds::DomainParticipant> Node::get_participant() const
+  {
+    return participant_;
+  }
+
+  void Node::spin()
+  {
+    bool use_notifier = false;
+    {
+      std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+      use_notifier = callback_groups_.size() > 1 || !wait_set_subscriptions_.empty();
+      if (use_notifier)
+      {
+        for (auto &group : callback_groups_)
+        {
+          group->get_channel().set_notifier(&spin_notifier_);
+        }
+        for (auto subscription : wait_set_subscriptions_)
+        {
+          subscription->set_event_notifier(&spin_notifier_);
+        }
+      }
+    }
+
+    Channel<ChannelCallback *> &default_channel = get_default_callback_group()->get_channel();
+    if (use_notifier)
+    {
+      // Wait on a notifier shared by every group (and the WaitSet of wait-set subscriptions)
+      // and serve them in turn.
+      while (!default_channel.is_closed() && !global_stop_flag.load())
+      {
+        uint64_t epoch = spin_notifier_.get_epoch();
+        spin_some();
+        if (default_channel.is_closed() || global_stop_flag.load())
+        {
+          break;
+        }
+        spin_notifier_.wait(epoch);
+      }
+      set_event_notifier(event_notifier_);
+    }
+    else if (default_channel.is_priority_dispatch())
+    {
+      // One at a time so each pick sees everything that is queued.
+      ChannelCallback *callback = nullptr;
+      while (!global_stop_flag.load() && default_channel.consume(callback))
+      {
+        if (callback)
+        {
+          callback->invoke();
+        }
+      }
+    }
+    else
+    {
+      std::vector<ChannelCallback *> callbacks;
+      while (!default_channel.is_closed() && !global_stop_flag.load())
+      {
+        while (default_channel.consume_all(callbacks))
+        {
+          for (auto callback : callbacks)
+          {
+            if (callback)
+            {
+              callback->invoke();
+            }
+          }
+          callbacks.clear();
+        }
+      }
+    }
+    stop_spin();
+  }
+
+  void Node::spin_some()
+  {
+    // Callbacks run without callback_groups_mutex_, so they can create timers, subscriptions
+    // or groups and read the node's statistics. Groups and subscriptions live as long as the
+    // node, so the copied pointers stay valid.
+    std::vector<CallbackGroup *> groups;
+    std::vector<ISubscriber *> wait_set_subscriptions;
+    {
+      std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+      groups.reserve(callback_groups_.size());
+      for (auto &group : callback_groups_)
+      {
+        groups.push_back(group.get());
+      }
+      wait_set_subscriptions = wait_set_subscriptions_;
+    }
+    for (auto subscription : wait_set_subscriptions)
+    {
+      subscription->poll();
+    }
+    for (auto group : groups)
+    {
+      if (group->try_claim())
+      {
+        group->spin_some();
+        group->release();
+      }
+    }
+  }
+
+  void Node::stop_spin()
+  {
+    std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+    for (auto &group : callback_groups_)
+    {
+      group->get_channel().close();
+    }
+  }
+
+  void Node::shutdown()
+  {
+    stop_spin();
+  }
+
+  CallbackGroup *Node::create_callback_group(CallbackGroupType type)
+  {
+    std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+    callback_groups_.push_back(std::make_unique<CallbackGroup>(type, options_.channel_options));
+    CallbackGroup *group = callback_groups_.back().get();
+    group->get_channel().set_notifier(event_notifier_);
+    return group;
+  }
+
+  CallbackGroup *Node::get_default_callback_group()
+  {
+    std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+    return callback_groups_.front().get();
+  }
+
+  CallbackGroup *Node::resolve_callback_group(CallbackGroup *callback_group)
+  {
+    std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+    if (callback_group == nullptr)
+    {
+      return callback_groups_.front().get();
+    }
+    for (auto &group : callback_groups_)
+    {
+      if (group.get() == callback_group)
+      {
+        return callback_group;
+      }
+    }
+    throw std::runtime_error("Callback group was not created by this node");
   }
 
   Clock* Node::get_clock()
@@ -425,9 +1103,664 @@ namespace lwrcl
     return clock_.get();
   }
 
+  uint64_t Node::get_dropped_callback_count()
+  {
+    uint64_t dropped = 0;
+    for_each_callback_group([&dropped](CallbackGroup *group)
+                            { dropped += group->get_channel().get_dropped_count(); });
+    return dropped;
+  }
+
+  void Node::set_event_notifier(EventNotifier *notifier)
+  {
+    std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+    event_notifier_ = notifier;
+    for (auto &group : callback_groups_)
+    {
+      group->get_channel().set_notifier(notifier);
+    }
+    for (auto subscription : wait_set_subscriptions_)
+    {
+      subscription->set_event_notifier(notifier);
+    }
+  }
+
+  void Node::add_wait_set_subscription(ISubscriber *subscription)
+  {
+    std::lock_guard<std::mutex> lock(callback_groups_mutex_);
+    wait_set_subscriptions_.push_back(subscription);
+    subscription->set_event_notifier(event_notifier_);
+  }
+
+  std::vector<CallbackStatisticsSnapshot> Node::get_statistics()
+  {
+    std::vector<CallbackStatisticsSnapshot> statistics;
+    for_each_callback_group(
+        [&statistics](CallbackGroup *group)
+        {
+          for (auto callback : group->get_callbacks())
+          {
+            statistics.push_back(callback->get_statistics().snapshot());
+          }
+        });
+    return statistics;
+  }
+
+  void Node::dump_statistics(std::ostream &out)
+  {
+    auto to_us = [](double ns)
+    { return ns / 1000.0; };
+    for (const auto &entry : get_statistics())
+    {
+      out << "[lwrcl statistics] " << entry.name
+          << ": invocations=" << entry.invocations
+          << " drops=" << entry.drops
+          << " wait_us(mean/p99/max)=" << to_us(entry.queue_wait.mean_ns()) << "/"
+          << to_us(entry.queue_wait.percentile_ns(99)) << "/" << to_us(entry.queue_wait.max_ns)
+          << " exec_us(mean/p99/max)=" << to_us(entry.execution.mean_ns()) << "/"
+          << to_us(entry.execution.percentile_ns(99)) << "/" << to_us(entry.execution.max_ns)
+          << std::endl;
+    }
+  }
+
+  void Node::register_callback(CallbackGroup *group, ChannelCallback *callback, const std::string &name)
+  {
+    callback->get_statistics().set_name(name);
+    callback->get_statistics().set_enabled(options_.enable_statistics);
+    group->add_callback(callback);
+  }
+
+  void Node::start_statistics_dump()
+  {
+    if (!options_.enable_statistics || options_.statistics_dump_period.count() <= 0)
+    {
+      return;
+    }
+    ThreadConfig thread_config = get_default_thread_config();
+    statistics_dump_thread_ = std::thread(
+        [this, thread_config]()
+        {
+          apply_thread_config(thread_config);
+          std::unique_lock<std::mutex> lock(statistics_dump_mutex_);
+          while (!statistics_dump_cv_.wait_for(lock, options_.statistics_dump_period, [this]
+                                               { return statistics_dump_stop_; }))
+          {
+            lock.unlock();
+            dump_statistics(std::cout);
+            lock.lock();
+          }
+        });
+  }
+
+  bool Node::has_pending_callbacks()
+  {
+    bool pending = false;
+    for_each_callback_group([&pending](CallbackGroup *group)
+                            { pending = pending || !group->get_channel().empty(); });
+    return pending;
+  }
+
   bool ok()
   {
     return !global_stop_flag.load();
   }
 
+  namespace
+  {
+    std::mutex default_thread_config_mutex;
+    ThreadConfig default_thread_config;
+  }
+
+  namespace
+  {
+#ifdef __linux__
+    // Arms fd to expire once at the absolute steady_clock (CLOCK_MONOTONIC) time deadline.
+    bool arm_timer_fd(int fd, std::chrono::steady_clock::time_point deadline)
+    {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+      itimerspec spec{};
+      spec.it_value.tv_sec = ns / 1000000000;
+      spec.it_value.tv_nsec = ns % 1000000000;
+      if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+      {
+        spec.it_value.tv_nsec = 1; // All zero would disarm the timer.
+      }
+      return timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+    }
+
+    struct ThreadTimerFd
+    {
+      ThreadTimerFd() : fd(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)) {}
+      ~ThreadTimerFd()
+      {
+        if (fd >= 0)
+        {
+          close(fd);
+        }
+      }
+      int fd;
+    };
+#endif
+  }
+
+  void precise_sleep_until(std::chrono::steady_clock::time_point deadline, const TimerBackendOptions &options)
+  {
+    auto wake_time = deadline - options.spin_threshold;
+    if (std::chrono::steady_clock::now() < wake_time)
+    {
+      bool slept = false;
+#ifdef __linux__
+      if (options.backend == TimerBackend::TIMERFD)
+      {
+        thread_local ThreadTimerFd timer_fd;
+        if (timer_fd.fd >= 0 && arm_timer_fd(timer_fd.fd, wake_time))
+        {
+          uint64_t count;
+          while (read(timer_fd.fd, &count, sizeof(count)) < 0 && errno == EINTR)
+          {
+          }
+          slept = true;
+        }
+      }
+#endif
+      if (!slept)
+      {
+        std::this_thread::sleep_until(wake_time);
+      }
+    }
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+    }
+  }
+
+  bool apply_thread_config(std::thread::native_handle_type thread, const ThreadConfig &config)
+  {
+    bool result = true;
+    if (config.policy != SchedulingPolicy::INHERIT)
+    {
+      int policy = SCHED_OTHER;
+      sched_param param{};
+      if (config.policy == SchedulingPolicy::FIFO || config.policy == SchedulingPolicy::RR)
+      {
+        policy = config.policy == SchedulingPolicy::FIFO ? SCHED_FIFO : SCHED_RR;
+        param.sched_priority = config.priority;
+      }
+      int error = pthread_setschedparam(thread, policy, &param);
+      if (error != 0)
+      {
+        std::cerr << "Error: Failed to set thread scheduling (policy " << policy << ", priority "
+                  << param.sched_priority << "): " << std::strerror(error) << std::endl;
+        result = false;
+      }
+    }
+    if (!config.cpu_affinity.empty())
+    {
+#ifdef __linux__
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      for (int cpu : config.cpu_affinity)
+      {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+          CPU_SET(cpu, &cpus);
+        }
+      }
+      int error = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+      if (error != 0)
+      {
+        std::cerr << "Error: Failed to set thread CPU affinity: " << std::strerror(error) << std::endl;
+        result = false;
+      }
+#else
+      std::cerr << "Error: Thread CPU affinity is not supported on this platform." << std::endl;
+      result = false;
+#endif
+    }
+    return result;
+  }
+
+  bool apply_thread_config(std::thread &thread, const ThreadConfig &config)
+  {
+    return apply_thread_config(thread.native_handle(), config);
+  }
+
+  bool apply_thread_config(const ThreadConfig &config)
+  {
+    return apply_thread_config(pthread_self(), config);
+  }
+
+  void set_default_thread_config(const ThreadConfig &config)
+  {
+    std::lock_guard<std::mutex> lock(default_thread_config_mutex);
+    default_thread_config = config;
+  }
+
+  ThreadConfig get_default_thread_config()
+  {
+    std::lock_guard<std::mutex> lock(default_thread_config_mutex);
+    return default_thread_config;
+  }
+
+  bool lock_memory()
+  {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+      std::cerr << "Error: mlockall failed: " << std::strerror(errno) << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  namespace
+  {
+    template <typename EntityQos>
+    void apply_qos(const QoS &qos, EntityQos &entity_qos)
+    {
+      entity_qos.reliability().kind = qos.get_reliability() == ReliabilityPolicy::RELIABLE
+                                          ? dds::RELIABLE_RELIABILITY_QOS
+                                          : dds::BEST_EFFORT_RELIABILITY_QOS;
+      if (qos.get_durability() != DurabilityPolicy::SYSTEM_DEFAULT)
+      {
+        entity_qos.durability().kind = qos.get_durability() == DurabilityPolicy::TRANSIENT_LOCAL
+                                           ? dds::TRANSIENT_LOCAL_DURABILITY_QOS
+                                           : dds::VOLATILE_DURABILITY_QOS;
+      }
+      if (qos.get_history() == HistoryPolicy::KEEP_ALL)
+      {
+        entity_qos.history().kind = dds::KEEP_ALL_HISTORY_QOS;
+      }
+      else
+      {
+        entity_qos.history().kind = dds::KEEP_LAST_HISTORY_QOS;
+        entity_qos.history().depth = static_cast<int32_t>(qos.get_depth() > 0 ? qos.get_depth() : 1);
+      }
+    }
+  }
+
+  void QoS::apply(dds::DataWriterQos &qos) const
+  {
+    apply_qos(*this, qos);
+  }
+
+  void QoS::apply(dds::DataReaderQos &qos) const
+  {
+    apply_qos(*this, qos);
+  }
+
+  bool parse_qos_profile(const std::string &name, QoS &qos)
+  {
+    if (name == "default" || name == "reliable")
+    {
+      qos = ReliableQoS();
+    }
+    else if (name == "sensor_data")
+    {
+      qos = SensorDataQoS();
+    }
+    else if (name == "transient_local")
+    {
+      qos = TransientLocalQoS();
+    }
+    else if (name == "clock")
+    {
+      qos = ClockQoS();
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  bool parse_scheduling_policy(const std::string &name, SchedulingPolicy &policy)
+  {
+    if (name == "INHERIT")
+    {
+      policy = SchedulingPolicy::INHERIT;
+    }
+    else if (name == "OTHER")
+    {
+      policy = SchedulingPolicy::OTHER;
+    }
+    else if (name == "FIFO")
+    {
+      policy = SchedulingPolicy::FIFO;
+    }
+    else if (name == "RR")
+    {
+      policy = SchedulingPolicy::RR;
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  TimerService &TimerService::instance()
+  {
+    // Never destroyed, so timers owned by static objects can still unregister at exit.
+    static TimerService *service = new TimerService();
+    return *service;
+  }
+
+  TimerService::TimerId TimerService::add(std::chrono::nanoseconds period, FireCallback fire, ClockType clock_type)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!worker_.joinable())
+    {
+      ThreadConfig thread_config = get_default_thread_config();
+      worker_ = std::thread([this, thread_config]()
+                            {
+                              apply_thread_config(thread_config);
+                              run(); });
+    }
+    TimerId id = next_id_++;
+    Entry &entry = timers_.emplace(id, Entry{period, std::chrono::steady_clock::time_point(), 0,
+                                             std::make_shared<FireCallback>(std::move(fire)), true,
+                                             clock_type == ClockType::ROS_TIME})
+                       .first->second;
+    schedule_from_now(id, entry);
+    wake();
+    return id;
+  }
+
+  void TimerService::remove(TimerId id)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    timers_.erase(id);
+    if (std::this_thread::get_id() != worker_.get_id())
+    {
+      fired_cv_.wait(lock, [this, id]
+                     { return firing_ != id; });
+    }
+  }
+
+  void TimerService::cancel(TimerId id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it != timers_.end())
+    {
+      it->second.active = false; // Its pending expiry turns stale.
+    }
+  }
+
+  void TimerService::reset(TimerId id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it == timers_.end())
+    {
+      return;
+    }
+    it->second.active = true;
+    schedule_from_now(id, it->second);
+    wake();
+  }
+
+  void TimerService::set_period(TimerId id, std::chrono::nanoseconds period)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it == timers_.end())
+    {
+      return;
+    }
+    Entry &entry = it->second;
+    if (entry.ros_time)
+    {
+      entry.ros_due = std::max(entry.ros_due + (period - entry.period).count(), TimeSource::now(ClockType::ROS_TIME));
+    }
+    else
+    {
+      entry.due = std::max(entry.due - entry.period + period, std::chrono::steady_clock::now());
+    }
+    entry.period = period;
+    if (entry.active)
+    {
+      if (entry.ros_time)
+      {
+        ros_expiries_.push(RosExpiry{entry.ros_due, id});
+      }
+      else
+      {
+        expiries_.push(Expiry{entry.due, id});
+      }
+      wake();
+    }
+  }
+
+  std::chrono::nanoseconds TimerService::time_until_trigger(TimerId id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it == timers_.end() || !it->second.active)
+    {
+      return std::chrono::nanoseconds::max();
+    }
+    if (it->second.ros_time)
+    {
+      return std::chrono::nanoseconds(it->second.ros_due - TimeSource::now(ClockType::ROS_TIME));
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(it->second.due - std::chrono::steady_clock::now());
+  }
+
+  size_t TimerService::size()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+  }
+
+  bool TimerService::set_thread_config(const ThreadConfig &config)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return worker_.joinable() && apply_thread_config(worker_, config);
+  }
+
+  void TimerService::set_backend(const TimerBackendOptions &options)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    backend_ = options;
+    wake();
+  }
+
+  void TimerService::on_ros_time_jump()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &timer : timers_)
+    {
+      if (timer.second.ros_time && timer.second.active)
+      {
+        schedule_from_now(timer.first, timer.second); // The old expiry turns stale.
+      }
+    }
+    wake();
+  }
+
+  void TimerService::on_ros_time_update()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ros_expiries_.empty())
+    {
+      wake();
+    }
+  }
+
+  void TimerService::schedule_from_now(TimerId id, Entry &entry)
+  {
+    if (entry.ros_time)
+    {
+      entry.ros_due = TimeSource::now(ClockType::ROS_TIME) + entry.period.count();
+      ros_expiries_.push(RosExpiry{entry.ros_due, id});
+    }
+    else
+    {
+      entry.due = std::chrono::steady_clock::now() + entry.period;
+      expiries_.push(Expiry{entry.due, id});
+    }
+  }
+
+  bool TimerService::is_stale(const Expiry &expiry) const
+  {
+    auto it = timers_.find(expiry.id);
+    return it == timers_.end() || !it->second.active || it->second.due != expiry.due;
+  }
+
+  bool TimerService::is_stale(const RosExpiry &expiry) const
+  {
+    auto it = timers_.find(expiry.id);
+    return it == timers_.end() || !it->second.active || it->second.ros_due != expiry.due;
+  }
+
+  // Requires mutex_.
+  void TimerService::wake()
+  {
+    cv_.notify_one();
+#ifdef __linux__
+    if (wake_fd_ >= 0)
+    {
+      uint64_t one = 1;
+      if (write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+      {
+        std::cerr << "Error: Failed to wake the timer service: " << std::strerror(errno) << std::endl;
+      }
+    }
+#endif
+  }
+
+  // Returns with mutex_ held, at or before due; the caller re-checks the heap.
+  void TimerService::wait_for_expiry(std::unique_lock<std::mutex> &lock, std::chrono::steady_clock::time_point due)
+  {
+    auto wake_time = due - backend_.spin_threshold;
+    if (std::chrono::steady_clock::now() >= wake_time)
+    {
+      // Busy-wait the rest without the lock. A timer added meanwhile is due at least one of
+      // its periods from now, so at worst it is seen spin_threshold late.
+      lock.unlock();
+      while (std::chrono::steady_clock::now() < due)
+      {
+      }
+      lock.lock();
+      return;
+    }
+#ifdef __linux__
+    if (backend_.backend == TimerBackend::TIMERFD)
+    {
+      if (timer_fd_ < 0)
+      {
+        timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      }
+      if (timer_fd_ >= 0 && wake_fd_ >= 0 && arm_timer_fd(timer_fd_, wake_time))
+      {
+        int timer_fd = timer_fd_;
+        int wake_fd = wake_fd_;
+        lock.unlock();
+        pollfd fds[2] = {{timer_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+        poll(fds, 2, -1);
+        uint64_t count;
+        while (read(timer_fd, &count, sizeof(count)) > 0)
+        {
+        }
+        while (read(wake_fd, &count, sizeof(count)) > 0)
+        {
+        }
+        lock.lock();
+        return;
+      }
+      std::cerr << "Error: timerfd unavailable, timer service falls back to sleep_until." << std::endl;
+      backend_.backend = TimerBackend::SLEEP_UNTIL;
+    }
+#endif
+    cv_.wait_until(lock, wake_time);
+  }
+
+  void TimerService::fire(std::unique_lock<std::mutex> &lock, TimerId id, std::chrono::steady_clock::time_point due)
+  {
+    Entry &entry = timers_.at(id);
+    if (entry.ros_time)
+    {
+      ros_expiries_.pop();
+      // Simulated time can leap many periods at once; like after a time jump, missed
+      // periods are skipped instead of fired back to back.
+      int64_t now = TimeSource::now(ClockType::ROS_TIME);
+      int64_t period = std::max<int64_t>(entry.period.count(), 1);
+      entry.ros_due += period;
+      if (entry.ros_due <= now)
+      {
+        entry.ros_due += (now - entry.ros_due) / period * period + period;
+      }
+      ros_expiries_.push(RosExpiry{entry.ros_due, id});
+    }
+    else
+    {
+      expiries_.pop();
+      entry.due += entry.period; // Drift-free: the schedule does not absorb lateness.
+      expiries_.push(Expiry{entry.due, id});
+    }
+    std::shared_ptr<FireCallback> fire_callback = entry.fire;
+    firing_ = id;
+    lock.unlock();
+    (*fire_callback)(due);
+    lock.lock();
+    firing_ = 0;
+    fired_cv_.notify_all();
+  }
+
+  void TimerService::run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+      while (!expiries_.empty() && is_stale(expiries_.top()))
+      {
+        expiries_.pop();
+      }
+      while (!ros_expiries_.empty() && is_stale(ros_expiries_.top()))
+      {
+        ros_expiries_.pop();
+      }
+      if (expiries_.empty() && ros_expiries_.empty())
+      {
+        cv_.wait(lock);
+        continue;
+      }
+      auto now = std::chrono::steady_clock::now();
+      if (!expiries_.empty() && expiries_.top().due <= now)
+      {
+        fire(lock, expiries_.top().id, expiries_.top().due);
+        continue;
+      }
+      auto deadline = std::chrono::steady_clock::time_point::max();
+      if (!expiries_.empty())
+      {
+        deadline = expiries_.top().due;
+      }
+      if (!ros_expiries_.empty())
+      {
+        int64_t ros_now = TimeSource::now(ClockType::ROS_TIME);
+        auto until_due = std::chrono::nanoseconds(ros_expiries_.top().due - ros_now);
+        if (until_due.count() <= 0)
+        {
+          // The due time expressed on the steady clock, so lateness reads the same as for steady timers.
+          fire(lock, ros_expiries_.top().id, now + until_due);
+          continue;
+        }
+        if (!TimeSource::is_simulated_time_active())
+        {
+          deadline = std::min(deadline, now + until_due); // ROS time is system time.
+        }
+      }
+      if (deadline == std::chrono::steady_clock::time_point::max())
+      {
+        cv_.wait(lock); // Only simulated time advancing can make a timer due.
+      }
+      else
+      {
+        wait_for_expiry(lock, deadline);
+      }
+    }
+  }
+
 } // namespace lwrcl
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "synchronizer.hpp"
+
+struct StampedMessage
+{
+  int64_t stamp;
+};
+
+namespace lwrcl
+{
+  template <>
+  struct MessageStamp<StampedMessage>
+  {
+    static int64_t get(const StampedMessage &message)
+    {
+      return message.stamp;
+    }
+  };
+} // namespace lwrcl
+
+using Sets = std::vector<std::tuple<int64_t, int64_t, int64_t>>;
+using Synchronizer = lwrcl::ApproximateTimeSynchronizer<StampedMessage, StampedMessage, StampedMessage>;
+
+// A set spread wider than max_interval evicts its earliest message, even when that message is
+// the pivot itself and not on the first topic.
+TEST(ApproximateTimeSynchronizer, maxIntervalEvictsEarliestSelectedMessage)
+{
+  Sets sets;
+  Synchronizer sync(10, [&sets](StampedMessage *a, StampedMessage *b, StampedMessage *c)
+                    { sets.emplace_back(a->stamp, b->stamp, c->stamp); });
+  sync.set_max_interval(std::chrono::nanoseconds(10));
+
+  StampedMessage a0{0}, a120{120}, a200{200}, b100{100}, b122{122}, c20{20}, c130{130};
+  sync.add<0>(&a0);
+  sync.add<0>(&a120);
+  sync.add<2>(&c20);
+  sync.add<2>(&c130);
+  // Pivot 100 selects A=120, B=100, C=130: spread 30, so B's 100 is dropped, not A's 120.
+  sync.add<1>(&b100);
+  EXPECT_TRUE(sets.empty());
+
+  sync.add<0>(&a200);
+  sync.add<1>(&b122);
+  ASSERT_EQ(sets.size(), 1u);
+  EXPECT_EQ(sets[0], std::make_tuple(int64_t{120}, int64_t{122}, int64_t{130}));
+  EXPECT_EQ(sync.get_matched_count(), 1u);
+}
+
+TEST(ApproximateTimeSynchronizer, matchesClosestMessages)
+{
+  Sets sets;
+  Synchronizer sync(10, [&sets](StampedMessage *a, StampedMessage *b, StampedMessage *c)
+                    { sets.emplace_back(a->stamp, b->stamp, c->stamp); });
+
+  StampedMessage a10{10}, a40{40}, b12{12}, b41{41}, c9{9}, c39{39};
+  sync.add<0>(&a10);
+  sync.add<1>(&b12);
+  sync.add<2>(&c9);
+  EXPECT_TRUE(sets.empty()); // B could still get a message closer to the pivot 12.
+  sync.add<0>(&a40);
+  sync.add<1>(&b41);
+  sync.add<2>(&c39);
+  ASSERT_EQ(sets.size(), 1u);
+  EXPECT_EQ(sets[0], std::make_tuple(int64_t{10}, int64_t{12}, int64_t{9}));
+}
@@ -69,6 +69,11 @@ namespace tf2_ros
     TF2_ROS_PUBLIC
     virtual ~TransformListener();
 
+    /** \brief Set the scheduling of the dedicated listener thread (no-op without spin_thread).
+     * The thread starts with lwrcl::get_default_thread_config(). */
+    TF2_ROS_PUBLIC
+    bool set_thread_config(const lwrcl::ThreadConfig &config);
+
   private:
     void init()
     {
@@ -85,8 +90,11 @@ namespace tf2_ros
         message_subscription_tf_ = tf_listener_node_->create_subscription<tf2_msgs::msg::TFMessage>(&sub_tf_message_type_, "tf", topic_qos, std::move(cb));
         message_subscription_tf_static_ = tf_listener_node_->create_subscription<tf2_msgs::msg::TFMessage>(&sub_tf_static_message_type_, "tf_static", topic_qos, std::move(static_cb));
         executor_->add_node(tf_listener_node_.get());
-        dedicated_listener_thread_ = std::make_unique<std::thread>([&]()
-                                                                   { executor_->spin(); });
+        lwrcl::ThreadConfig thread_config = lwrcl::get_default_thread_config();
+        dedicated_listener_thread_ = std::make_unique<std::thread>([this, thread_config]()
+                                                                   {
+                                                                     lwrcl::apply_thread_config(thread_config);
+                                                                     executor_->spin(); });
       }
       else
       {
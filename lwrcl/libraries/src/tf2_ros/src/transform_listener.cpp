@@ -55,6 +55,15 @@ namespace tf2_ros
     }
   }
 
+  bool TransformListener::set_thread_config(const lwrcl::ThreadConfig &config)
+  {
+    if (!dedicated_listener_thread_)
+    {
+      return false;
+    }
+    return lwrcl::apply_thread_config(*dedicated_listener_thread_, config);
+  }
+
   void TransformListener::subscription_callback(
       tf2_msgs::msg::TFMessage *message,
       bool is_static)